@@ -156,6 +156,7 @@ static int restore_tty;
 
 #if HAVE_PTHREADS
 static void free_input_threads(void);
+static void free_encoder_threads(void);
 #endif
 
 /* sub2video hack:
@@ -465,6 +466,10 @@ static void ffmpeg_cleanup(int ret)
         av_log(NULL, AV_LOG_INFO, "bench: maxrss=%ikB\n", maxrss);
     }
 
+#if HAVE_PTHREADS
+    free_encoder_threads();
+#endif
+
     for (i = 0; i < nb_filtergraphs; i++) {
         FilterGraph *fg = filtergraphs[i];
         avfilter_graph_free(&fg->graph);
@@ -792,26 +797,44 @@ static int check_recording_time(OutputStream *ost)
     return 1;
 }
 
-static void do_audio_out(AVFormatContext *s, OutputStream *ost,
-                         AVFrame *frame)
+/*
+ * Send an encoded packet to the muxer. When the encoder of ost runs in its
+ * own thread, this is only ever called from the main thread.
+ */
+static void mux_encoded_packet(OutputStream *ost, AVPacket *pkt)
+{
+    int pkt_size = pkt->size;
+
+    write_frame(output_files[ost->file_index]->ctx, pkt, ost);
+
+    if (ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO && vstats_filename && pkt_size)
+        do_video_stats(ost, pkt_size);
+}
+
+static int output_encoded_packet(OutputStream *ost, AVPacket *pkt)
+{
+#if HAVE_PTHREADS
+    if (ost->enc_pkt_queue) {
+        int ret = av_thread_message_queue_send(ost->enc_pkt_queue, pkt, 0);
+        if (ret < 0)
+            av_packet_unref(pkt);
+        return ret;
+    }
+#endif
+    mux_encoded_packet(ost, pkt);
+    return 0;
+}
+
+static int encode_audio_frame(OutputStream *ost, AVFrame *frame)
 {
     AVCodecContext *enc = ost->enc_ctx;
     AVPacket pkt;
-    int got_packet = 0;
+    int ret, got_packet = 0;
 
     av_init_packet(&pkt);
     pkt.data = NULL;
     pkt.size = 0;
 
-    if (!check_recording_time(ost))
-        return;
-
-    if (frame->pts == AV_NOPTS_VALUE || audio_sync_method < 0)
-        frame->pts = ost->sync_opts;
-    ost->sync_opts = frame->pts + frame->nb_samples;
-    ost->samples_encoded += frame->nb_samples;
-    ost->frames_encoded++;
-
     av_assert0(pkt.size || !pkt.data);
     update_benchmark(NULL);
     if (debug_ts) {
@@ -821,9 +844,9 @@ static void do_audio_out(AVFormatContext *s, OutputStream *ost,
                enc->time_base.num, enc->time_base.den);
     }
 
-    if (avcodec_encode_audio2(enc, &pkt, frame, &got_packet) < 0) {
+    if ((ret = avcodec_encode_audio2(enc, &pkt, frame, &got_packet)) < 0) {
         av_log(NULL, AV_LOG_FATAL, "Audio encoding failed (avcodec_encode_audio2)\n");
-        exit_program(1);
+        return ret;
     }
     update_benchmark("encode_audio %d.%d", ost->file_index, ost->index);
 
@@ -837,8 +860,132 @@ static void do_audio_out(AVFormatContext *s, OutputStream *ost,
                    av_ts2str(pkt.dts), av_ts2timestr(pkt.dts, &ost->st->time_base));
         }
 
-        write_frame(s, &pkt, ost);
+        return output_encoded_packet(ost, &pkt);
     }
+    return 0;
+}
+
+static int encode_video_frame(OutputStream *ost, AVFrame *in_picture)
+{
+    AVCodecContext *enc = ost->enc_ctx;
+    AVPacket pkt;
+    int ret, got_packet;
+
+    av_init_packet(&pkt);
+    pkt.data = NULL;
+    pkt.size = 0;
+
+    if (!ost->frame_aspect_ratio.num)
+        enc->sample_aspect_ratio = in_picture->sample_aspect_ratio;
+
+    update_benchmark(NULL);
+    if (debug_ts) {
+        av_log(NULL, AV_LOG_INFO, "encoder <- type:video "
+               "frame_pts:%s frame_pts_time:%s time_base:%d/%d\n",
+               av_ts2str(in_picture->pts), av_ts2timestr(in_picture->pts, &enc->time_base),
+               enc->time_base.num, enc->time_base.den);
+    }
+
+    ret = avcodec_encode_video2(enc, &pkt, in_picture, &got_packet);
+    update_benchmark("encode_video %d.%d", ost->file_index, ost->index);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_FATAL, "Video encoding failed\n");
+        return ret;
+    }
+
+    if (got_packet) {
+        if (debug_ts) {
+            av_log(NULL, AV_LOG_INFO, "encoder -> type:video "
+                   "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n",
+                   av_ts2str(pkt.pts), av_ts2timestr(pkt.pts, &enc->time_base),
+                   av_ts2str(pkt.dts), av_ts2timestr(pkt.dts, &enc->time_base));
+        }
+
+        if (pkt.pts == AV_NOPTS_VALUE && !(enc->codec->capabilities & AV_CODEC_CAP_DELAY))
+            pkt.pts = in_picture->pts;
+
+        av_packet_rescale_ts(&pkt, enc->time_base, ost->st->time_base);
+
+        if (debug_ts) {
+            av_log(NULL, AV_LOG_INFO, "encoder -> type:video "
+                "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n",
+                av_ts2str(pkt.pts), av_ts2timestr(pkt.pts, &ost->st->time_base),
+                av_ts2str(pkt.dts), av_ts2timestr(pkt.dts, &ost->st->time_base));
+        }
+
+        /* if two pass, output log */
+        if (ost->logfile && enc->stats_out) {
+            fprintf(ost->logfile, "%s", enc->stats_out);
+        }
+
+        return output_encoded_packet(ost, &pkt);
+    }
+    return 0;
+}
+
+static int encode_frame(OutputStream *ost, AVFrame *frame)
+{
+    if (ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO)
+        return encode_video_frame(ost, frame);
+    return encode_audio_frame(ost, frame);
+}
+
+#if HAVE_PTHREADS
+static int drain_encoder_packets(OutputStream *ost, unsigned flags)
+{
+    AVPacket pkt;
+    int ret;
+
+    while ((ret = av_thread_message_queue_recv(ost->enc_pkt_queue, &pkt, flags)) >= 0)
+        mux_encoded_packet(ost, &pkt);
+
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+}
+#endif
+
+/*
+ * Encode frame, or hand a new reference to it to the encoder thread of ost.
+ */
+static void submit_frame(OutputStream *ost, AVFrame *frame)
+{
+#if HAVE_PTHREADS
+    if (ost->enc_frame_queue) {
+        AVFrame *ref = av_frame_clone(frame);
+        int ret;
+
+        if (!ref) {
+            av_log(NULL, AV_LOG_FATAL, "Could not allocate a frame for the encoder thread\n");
+            exit_program(1);
+        }
+        /* Mux what the encoder produced so far before queuing another frame:
+         * this bounds the number of packets waiting for the main thread. */
+        ret = drain_encoder_packets(ost, AV_THREAD_MESSAGE_NONBLOCK);
+        if (ret >= 0)
+            ret = av_thread_message_queue_send(ost->enc_frame_queue, &ref, 0);
+        if (ret < 0) {
+            av_frame_free(&ref);
+            exit_program(1);
+        }
+        return;
+    }
+#endif
+    if (encode_frame(ost, frame) < 0)
+        exit_program(1);
+}
+
+static void do_audio_out(AVFormatContext *s, OutputStream *ost,
+                         AVFrame *frame)
+{
+    if (!check_recording_time(ost))
+        return;
+
+    if (frame->pts == AV_NOPTS_VALUE || audio_sync_method < 0)
+        frame->pts = ost->sync_opts;
+    ost->sync_opts = frame->pts + frame->nb_samples;
+    ost->samples_encoded += frame->nb_samples;
+    ost->frames_encoded++;
+
+    submit_frame(ost, frame);
 }
 
 static void do_subtitle_out(AVFormatContext *s,
@@ -930,14 +1077,13 @@ static void do_video_out(AVFormatContext *s,
                          AVFrame *next_picture,
                          double sync_ipts)
 {
-    int ret, format_video_sync;
+    int format_video_sync;
     AVPacket pkt;
     AVCodecContext *enc = ost->enc_ctx;
     AVCodecContext *mux_enc = ost->st->codec;
     int nb_frames, nb0_frames, i;
     double delta, delta0;
     double duration = 0;
-    int frame_size = 0;
     InputStream *ist = NULL;
     AVFilterContext *filter = ost->filter->filter;
 
@@ -1106,7 +1252,7 @@ static void do_video_out(AVFormatContext *s,
     } else
 #endif
     {
-        int got_packet, forced_keyframe = 0;
+        int forced_keyframe = 0;
         double pts_time;
 
         if (enc->flags & (AV_CODEC_FLAG_INTERLACED_DCT | AV_CODEC_FLAG_INTERLACED_ME) &&
@@ -1163,51 +1309,14 @@ static void do_video_out(AVFormatContext *s,
             av_log(NULL, AV_LOG_DEBUG, "Forced keyframe at time %f\n", pts_time);
         }
 
-        update_benchmark(NULL);
-        if (debug_ts) {
-            av_log(NULL, AV_LOG_INFO, "encoder <- type:video "
-                   "frame_pts:%s frame_pts_time:%s time_base:%d/%d\n",
-                   av_ts2str(in_picture->pts), av_ts2timestr(in_picture->pts, &enc->time_base),
-                   enc->time_base.num, enc->time_base.den);
-        }
+        /* the encoder takes its aspect ratio from the newest filtered frame,
+         * also when duplicating the previous one */
+        if (next_picture)
+            in_picture->sample_aspect_ratio = next_picture->sample_aspect_ratio;
 
         ost->frames_encoded++;
 
-        ret = avcodec_encode_video2(enc, &pkt, in_picture, &got_packet);
-        update_benchmark("encode_video %d.%d", ost->file_index, ost->index);
-        if (ret < 0) {
-            av_log(NULL, AV_LOG_FATAL, "Video encoding failed\n");
-            exit_program(1);
-        }
-
-        if (got_packet) {
-            if (debug_ts) {
-                av_log(NULL, AV_LOG_INFO, "encoder -> type:video "
-                       "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n",
-                       av_ts2str(pkt.pts), av_ts2timestr(pkt.pts, &enc->time_base),
-                       av_ts2str(pkt.dts), av_ts2timestr(pkt.dts, &enc->time_base));
-            }
-
-            if (pkt.pts == AV_NOPTS_VALUE && !(enc->codec->capabilities & AV_CODEC_CAP_DELAY))
-                pkt.pts = ost->sync_opts;
-
-            av_packet_rescale_ts(&pkt, enc->time_base, ost->st->time_base);
-
-            if (debug_ts) {
-                av_log(NULL, AV_LOG_INFO, "encoder -> type:video "
-                    "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n",
-                    av_ts2str(pkt.pts), av_ts2timestr(pkt.pts, &ost->st->time_base),
-                    av_ts2str(pkt.dts), av_ts2timestr(pkt.dts, &ost->st->time_base));
-            }
-
-            frame_size = pkt.size;
-            write_frame(s, &pkt, ost);
-
-            /* if two pass, output log */
-            if (ost->logfile && enc->stats_out) {
-                fprintf(ost->logfile, "%s", enc->stats_out);
-            }
-        }
+        submit_frame(ost, in_picture);
     }
     ost->sync_opts++;
     /*
@@ -1216,9 +1325,6 @@ static void do_video_out(AVFormatContext *s,
      * flush, we need to limit them here, before they go into encoder.
      */
     ost->frame_number++;
-
-    if (vstats_filename && frame_size)
-        do_video_stats(ost, frame_size);
   }
 
     if (!ost->last_frame)
@@ -1309,6 +1415,12 @@ static int reap_filters(int flush)
             continue;
         filter = ost->filter->filter;
 
+#if HAVE_PTHREADS
+        if (ost->enc_pkt_queue &&
+            drain_encoder_packets(ost, AV_THREAD_MESSAGE_NONBLOCK) < 0)
+            exit_program(1);
+#endif
+
         if (!ost->filtered_frame && !(ost->filtered_frame = av_frame_alloc())) {
             return AVERROR(ENOMEM);
         }
@@ -1354,9 +1466,6 @@ static int reap_filters(int flush)
 
             switch (filter->inputs[0]->type) {
             case AVMEDIA_TYPE_VIDEO:
-                if (!ost->frame_aspect_ratio.num)
-                    enc->sample_aspect_ratio = filtered_frame->sample_aspect_ratio;
-
                 if (debug_ts) {
                     av_log(NULL, AV_LOG_INFO, "filter -> pts:%s pts_time:%s exact:%f time_base:%d/%d\n",
                             av_ts2str(filtered_frame->pts), av_ts2timestr(filtered_frame->pts, &enc->time_base),
@@ -3646,6 +3755,136 @@ static int init_input_threads(void)
     return 0;
 }
 
+static void free_frame_message(void *msg)
+{
+    av_frame_free(msg);
+}
+
+static void free_packet_message(void *msg)
+{
+    av_packet_unref(msg);
+}
+
+static void *encoder_thread(void *arg)
+{
+    OutputStream *ost = arg;
+    AVFrame *frame;
+    int ret;
+
+    while ((ret = av_thread_message_queue_recv(ost->enc_frame_queue, &frame, 0)) >= 0) {
+        ret = encode_frame(ost, frame);
+        av_frame_free(&frame);
+        if (ret < 0)
+            break;
+    }
+
+    /* wake up the main thread, whether it is queuing frames or waiting for packets */
+    av_thread_message_queue_set_err_send(ost->enc_frame_queue, ret);
+    av_thread_message_queue_set_err_recv(ost->enc_pkt_queue, ret);
+
+    return NULL;
+}
+
+/*
+ * Stop the encoder threads without waiting for the queued frames to be
+ * encoded, used on abnormal termination.
+ */
+static void free_encoder_threads(void)
+{
+    int i;
+
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+
+        if (!ost || !ost->enc_frame_queue)
+            continue;
+        av_thread_message_queue_set_err_send(ost->enc_pkt_queue, AVERROR_EOF);
+        av_thread_message_queue_set_err_recv(ost->enc_frame_queue, AVERROR_EOF);
+        av_thread_message_flush(ost->enc_frame_queue);
+
+        pthread_join(ost->enc_thread, NULL);
+        av_thread_message_queue_free(&ost->enc_frame_queue);
+        av_thread_message_queue_free(&ost->enc_pkt_queue);
+    }
+}
+
+/*
+ * Wait for the encoder threads to encode all the queued frames and mux the
+ * resulting packets, so that the encoders can be flushed from the main thread.
+ */
+static void finish_encoder_threads(void)
+{
+    int i, ret, err = 0;
+
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+        if (ost->enc_frame_queue)
+            av_thread_message_queue_set_err_recv(ost->enc_frame_queue, AVERROR_EOF);
+    }
+
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+
+        if (!ost->enc_frame_queue)
+            continue;
+        ret = drain_encoder_packets(ost, 0);
+        if (ret < 0)
+            err = ret;
+
+        pthread_join(ost->enc_thread, NULL);
+        av_thread_message_queue_free(&ost->enc_frame_queue);
+        av_thread_message_queue_free(&ost->enc_pkt_queue);
+    }
+
+    if (err < 0)
+        exit_program(1);
+}
+
+static int init_encoder_threads(void)
+{
+    int i, ret;
+
+    if (enc_thread_queue_size <= 0)
+        return 0;
+    if (do_benchmark_all) {
+        av_log(NULL, AV_LOG_WARNING, "Encoder threads are disabled by -benchmark_all\n");
+        return 0;
+    }
+
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+
+        if (!ost->encoding_needed || !ost->filter)
+            continue;
+
+        ret = av_thread_message_queue_alloc(&ost->enc_frame_queue,
+                                            enc_thread_queue_size, sizeof(AVFrame *));
+        if (ret < 0)
+            return ret;
+        av_thread_message_queue_set_free_func(ost->enc_frame_queue, free_frame_message);
+
+        /* The encoder thread outputs at most one packet per frame, and the
+         * main thread collects its packets before queuing each new frame:
+         * with two spare slots for the frames in flight, sending a packet
+         * never blocks the encoder thread. */
+        ret = av_thread_message_queue_alloc(&ost->enc_pkt_queue,
+                                            enc_thread_queue_size + 2, sizeof(AVPacket));
+        if (ret < 0) {
+            av_thread_message_queue_free(&ost->enc_frame_queue);
+            return ret;
+        }
+        av_thread_message_queue_set_free_func(ost->enc_pkt_queue, free_packet_message);
+
+        if ((ret = pthread_create(&ost->enc_thread, NULL, encoder_thread, ost))) {
+            av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+            av_thread_message_queue_free(&ost->enc_frame_queue);
+            av_thread_message_queue_free(&ost->enc_pkt_queue);
+            return AVERROR(ret);
+        }
+    }
+    return 0;
+}
+
 static int get_input_packet_mt(InputFile *f, AVPacket *pkt)
 {
     return av_thread_message_queue_recv(f->in_thread_queue, pkt,
@@ -4143,6 +4382,8 @@ static int transcode(void)
 #if HAVE_PTHREADS
     if ((ret = init_input_threads()) < 0)
         goto fail;
+    if ((ret = init_encoder_threads()) < 0)
+        goto fail;
 #endif
 
     while (!received_sigterm) {
@@ -4182,6 +4423,9 @@ static int transcode(void)
             process_input_packet(ist, NULL, 0);
         }
     }
+#if HAVE_PTHREADS
+    finish_encoder_threads();
+#endif
     flush_encoders();
 
     term_exit();
@@ -490,6 +490,12 @@ typedef struct OutputStream {
 
     /* frame encode sum of squared error values */
     int64_t error[4];
+
+#if HAVE_PTHREADS
+    AVThreadMessageQueue *enc_frame_queue; /* frames to be encoded by enc_thread */
+    AVThreadMessageQueue *enc_pkt_queue;   /* packets from enc_thread, to be muxed */
+    pthread_t enc_thread;                  /* thread running the encoder */
+#endif
 } OutputStream;
 
 typedef struct OutputFile {
@@ -529,6 +535,7 @@ extern int video_sync_method;
 extern float frame_drop_threshold;
 extern int do_benchmark;
 extern int do_benchmark_all;
+extern int enc_thread_queue_size;
 extern int do_deinterlace;
 extern int do_hex_dump;
 extern int do_pkt_dump;
@@ -106,6 +106,7 @@ float frame_drop_threshold = 0;
 int do_deinterlace    = 0;
 int do_benchmark      = 0;
 int do_benchmark_all  = 0;
+int enc_thread_queue_size = 0;
 int do_hex_dump       = 0;
 int do_pkt_dump       = 0;
 int copy_ts           = 0;
@@ -3238,6 +3239,8 @@ const OptionDef options[] = {
       "enable or disable interaction on standard input" },
     { "timelimit",      HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_timelimit },
         "set max runtime in seconds", "limit" },
+    { "enc_thread_queue_size", HAS_ARG | OPT_INT | OPT_EXPERT,       { &enc_thread_queue_size },
+        "run each encoder in its own thread, queuing up to the given number of frames", "size" },
     { "dump",           OPT_BOOL | OPT_EXPERT,                       { &do_pkt_dump },
         "dump each input packet" },
     { "hex",            OPT_BOOL | OPT_EXPERT,                       { &do_hex_dump },
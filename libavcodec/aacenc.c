@@ -506,6 +506,125 @@ static void copy_input_samples(AACEncContext *s, const AVFrame *frame)
     }
 }
 
+typedef struct ThreadData {
+    FFPsyWindowInfo *windows;
+    int start_ch[AAC_MAX_CHANNELS];     ///< first channel of each element
+    uint8_t tns_mode[AAC_MAX_CHANNELS];
+    uint8_t is_mode[AAC_MAX_CHANNELS];
+    uint8_t pred_mode[AAC_MAX_CHANNELS];
+} ThreadData;
+
+/**
+ * Copy the encoder state to the context a channel element is coded with,
+ * keeping the scratch buffers and PNS PRNG of the element.
+ */
+static void update_element_context(AACEncContext *dst, const AACEncContext *src)
+{
+    LPCContext lpc = dst->lpc;
+    AVLFG lfg      = dst->lfg;
+
+    memcpy(dst, src, offsetof(AACEncContext, qcoefs));
+    dst->lpc = lpc;
+    dst->lfg = lfg;
+}
+
+/**
+ * Search the quantizers and coding tools of one channel element. Elements
+ * only share read-only state, so they are searched in parallel.
+ */
+static int quantize_element(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    AACEncContext *s   = &((AACEncContext *)avctx->priv_data)->element_ctx[jobnr];
+    ThreadData *td     = arg;
+    ChannelElement *cpe = &s->cpe[jobnr];
+    SingleChannelElement *sce;
+    const int start_ch = td->start_ch[jobnr];
+    const int tag      = s->chan_map[jobnr + 1];
+    const int chans    = tag == TYPE_CPE ? 2 : 1;
+    FFPsyWindowInfo *wi = td->windows + start_ch;
+    int ch, w;
+
+    td->tns_mode[jobnr] = td->is_mode[jobnr] = td->pred_mode[jobnr] = 0;
+
+    s->cur_type = tag;
+    for (ch = 0; ch < chans; ch++) {
+        s->cur_channel = start_ch + ch;
+        if (s->options.pns && s->coder->mark_pns)
+            s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
+        s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
+    }
+    if (chans > 1
+        && wi[0].window_type[0] == wi[1].window_type[0]
+        && wi[0].window_shape   == wi[1].window_shape) {
+
+        cpe->common_window = 1;
+        for (w = 0; w < wi[0].num_windows; w++) {
+            if (wi[0].grouping[w] != wi[1].grouping[w]) {
+                cpe->common_window = 0;
+                break;
+            }
+        }
+    }
+    for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
+        sce = &cpe->ch[ch];
+        s->cur_channel = start_ch + ch;
+        if (s->options.tns && s->coder->search_for_tns)
+            s->coder->search_for_tns(s, sce);
+        if (s->options.tns && s->coder->apply_tns_filt)
+            s->coder->apply_tns_filt(s, sce);
+        if (sce->tns.present)
+            td->tns_mode[jobnr] = 1;
+        if (s->options.pns && s->coder->search_for_pns)
+            s->coder->search_for_pns(s, avctx, sce);
+    }
+    s->cur_channel = start_ch;
+    if (s->options.intensity_stereo) { /* Intensity Stereo */
+        if (s->coder->search_for_is)
+            s->coder->search_for_is(s, avctx, cpe);
+        if (cpe->is_mode) td->is_mode[jobnr] = 1;
+        apply_intensity_stereo(cpe);
+    }
+    if (s->options.pred) { /* Prediction */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->options.pred && s->coder->search_for_pred)
+                s->coder->search_for_pred(s, sce);
+            if (cpe->ch[ch].ics.predictor_present) td->pred_mode[jobnr] = 1;
+        }
+        if (s->coder->adjust_common_pred)
+            s->coder->adjust_common_pred(s, cpe);
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->options.pred && s->coder->apply_main_pred)
+                s->coder->apply_main_pred(s, sce);
+        }
+        s->cur_channel = start_ch;
+    }
+    if (s->options.mid_side) { /* Mid/Side stereo */
+        if (s->options.mid_side == -1 && s->coder->search_for_ms)
+            s->coder->search_for_ms(s, cpe);
+        else if (cpe->common_window)
+            memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
+        apply_mid_side_stereo(cpe);
+    }
+    adjust_frame_information(cpe, chans);
+    if (s->options.ltp) { /* LTP */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->coder->search_for_ltp)
+                s->coder->search_for_ltp(s, sce, cpe->common_window);
+            if (sce->ics.ltp.present) td->pred_mode[jobnr] = 1;
+        }
+        s->cur_channel = start_ch;
+        if (s->coder->adjust_common_ltp)
+            s->coder->adjust_common_ltp(s, cpe);
+    }
+    return 0;
+}
+
 static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                             const AVFrame *frame, int *got_packet_ptr)
 {
@@ -519,6 +638,7 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     int ms_mode = 0, is_mode = 0, tns_mode = 0, pred_mode = 0;
     int chan_el_counter[4];
     FFPsyWindowInfo windows[AAC_MAX_CHANNELS];
+    ThreadData td;
 
     if (s->last_frame == 2)
         return 0;
@@ -633,6 +753,7 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     }
     if ((ret = ff_alloc_packet2(avctx, avpkt, 8192 * s->channels, 0)) < 0)
         return ret;
+    td.windows = windows;
     frame_bits = its = 0;
     do {
         init_put_bits(&s->pb, avpkt->data, avpkt->size);
@@ -642,6 +763,8 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
         start_ch = 0;
         target_bits = 0;
         memset(chan_el_counter, 0, sizeof(chan_el_counter));
+        /* The psychoacoustic model carries its bit reservoir state from one
+         * channel element to the next, so it runs serially. */
         for (i = 0; i < s->chan_map[0]; i++) {
             FFPsyWindowInfo* wi = windows + start_ch;
             const float *coeffs[2];
@@ -651,8 +774,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
             cpe->common_window = 0;
             memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
             memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
-            put_bits(&s->pb, 3, tag);
-            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             for (ch = 0; ch < chans; ch++) {
                 sce = &cpe->ch[ch];
                 coeffs[ch] = sce->coeffs;
@@ -674,82 +795,26 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                     * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
                 s->psy.bitres.alloc /= chans;
             }
-            s->cur_type = tag;
-            for (ch = 0; ch < chans; ch++) {
-                s->cur_channel = start_ch + ch;
-                if (s->options.pns && s->coder->mark_pns)
-                    s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
-                s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
-            }
-            if (chans > 1
-                && wi[0].window_type[0] == wi[1].window_type[0]
-                && wi[0].window_shape   == wi[1].window_shape) {
-
-                cpe->common_window = 1;
-                for (w = 0; w < wi[0].num_windows; w++) {
-                    if (wi[0].grouping[w] != wi[1].grouping[w]) {
-                        cpe->common_window = 0;
-                        break;
-                    }
-                }
-            }
-            for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
-                sce = &cpe->ch[ch];
-                s->cur_channel = start_ch + ch;
-                if (s->options.tns && s->coder->search_for_tns)
-                    s->coder->search_for_tns(s, sce);
-                if (s->options.tns && s->coder->apply_tns_filt)
-                    s->coder->apply_tns_filt(s, sce);
-                if (sce->tns.present)
-                    tns_mode = 1;
-                if (s->options.pns && s->coder->search_for_pns)
-                    s->coder->search_for_pns(s, avctx, sce);
-            }
-            s->cur_channel = start_ch;
-            if (s->options.intensity_stereo) { /* Intensity Stereo */
-                if (s->coder->search_for_is)
-                    s->coder->search_for_is(s, avctx, cpe);
-                if (cpe->is_mode) is_mode = 1;
-                apply_intensity_stereo(cpe);
-            }
-            if (s->options.pred) { /* Prediction */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->search_for_pred)
-                        s->coder->search_for_pred(s, sce);
-                    if (cpe->ch[ch].ics.predictor_present) pred_mode = 1;
-                }
-                if (s->coder->adjust_common_pred)
-                    s->coder->adjust_common_pred(s, cpe);
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->apply_main_pred)
-                        s->coder->apply_main_pred(s, sce);
-                }
-                s->cur_channel = start_ch;
-            }
-            if (s->options.mid_side) { /* Mid/Side stereo */
-                if (s->options.mid_side == -1 && s->coder->search_for_ms)
-                    s->coder->search_for_ms(s, cpe);
-                else if (cpe->common_window)
-                    memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
-                apply_mid_side_stereo(cpe);
-            }
-            adjust_frame_information(cpe, chans);
-            if (s->options.ltp) { /* LTP */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->coder->search_for_ltp)
-                        s->coder->search_for_ltp(s, sce, cpe->common_window);
-                    if (sce->ics.ltp.present) pred_mode = 1;
-                }
-                s->cur_channel = start_ch;
-                if (s->coder->adjust_common_ltp)
-                    s->coder->adjust_common_ltp(s, cpe);
-            }
+            update_element_context(&s->element_ctx[i], s);
+            td.start_ch[i] = start_ch;
+            start_ch += chans;
+        }
+
+        avctx->execute2(avctx, quantize_element, &td, NULL, s->chan_map[0]);
+
+        /* twoloop adjusts the analysis cutoff, keep the last update */
+        s->psy.cutoff = s->element_ctx[s->chan_map[0] - 1].psy.cutoff;
+
+        for (i = 0; i < s->chan_map[0]; i++) {
+            tag      = s->chan_map[i+1];
+            chans    = tag == TYPE_CPE ? 2 : 1;
+            cpe      = &s->cpe[i];
+            start_ch = td.start_ch[i];
+            tns_mode  |= td.tns_mode[i];
+            is_mode   |= td.is_mode[i];
+            pred_mode |= td.pred_mode[i];
+            put_bits(&s->pb, 3, tag);
+            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             if (chans == 2) {
                 put_bits(&s->pb, 1, cpe->common_window);
                 if (cpe->common_window) {
@@ -766,7 +831,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                 s->cur_channel = start_ch + ch;
                 encode_individual_channel(avctx, s, &cpe->ch[ch], cpe->common_window);
             }
-            start_ch += chans;
         }
 
         if (avctx->flags & CODEC_FLAG_QSCALE) {
@@ -855,6 +919,7 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
 static av_cold int aac_encode_end(AVCodecContext *avctx)
 {
     AACEncContext *s = avctx->priv_data;
+    int i;
 
     av_log(avctx, AV_LOG_INFO, "Qavg: %.3f\n", s->lambda_sum / s->lambda_count);
 
@@ -862,6 +927,10 @@ static av_cold int aac_encode_end(AVCodecContext *avctx)
     ff_mdct_end(&s->mdct128);
     ff_psy_end(&s->psy);
     ff_lpc_end(&s->lpc);
+    if (s->element_ctx)
+        for (i = 0; i < s->chan_map[0]; i++)
+            ff_lpc_end(&s->element_ctx[i].lpc);
+    av_freep(&s->element_ctx);
     if (s->psypp)
         ff_psy_preprocess_end(s->psypp);
     av_freep(&s->buffer.samples);
@@ -898,6 +967,7 @@ static av_cold int alloc_buffers(AVCodecContext *avctx, AACEncContext *s)
     int ch;
     FF_ALLOCZ_ARRAY_OR_GOTO(avctx, s->buffer.samples, s->channels, 3 * 1024 * sizeof(s->buffer.samples[0]), alloc_fail);
     FF_ALLOCZ_ARRAY_OR_GOTO(avctx, s->cpe, s->chan_map[0], sizeof(ChannelElement), alloc_fail);
+    FF_ALLOCZ_ARRAY_OR_GOTO(avctx, s->element_ctx, s->chan_map[0], sizeof(AACEncContext), alloc_fail);
     FF_ALLOCZ_OR_GOTO(avctx, avctx->extradata, 5 + AV_INPUT_BUFFER_PADDING_SIZE, alloc_fail);
 
     for(ch = 0; ch < s->channels; ch++)
@@ -1031,7 +1101,12 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
         goto fail;
     s->psypp = ff_psy_preprocess_init(avctx);
     ff_lpc_init(&s->lpc, 2*avctx->frame_size, TNS_MAX_ORDER, FF_LPC_TYPE_LEVINSON);
-    av_lfg_init(&s->lfg, 0x72adca55);
+    for (i = 0; i < s->chan_map[0]; i++) {
+        if ((ret = ff_lpc_init(&s->element_ctx[i].lpc, 2*avctx->frame_size,
+                               TNS_MAX_ORDER, FF_LPC_TYPE_LEVINSON)) < 0)
+            goto fail;
+        av_lfg_init(&s->element_ctx[i].lfg, 0x72adca55 + i);
+    }
 
     if (HAVE_MIPSDSP)
         ff_aac_coder_init_mips(s);
@@ -1086,7 +1161,8 @@ AVCodec ff_aac_encoder = {
     .defaults       = aac_encode_defaults,
     .supported_samplerates = mpeg4audio_sample_rates,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_FLTP,
                                                      AV_SAMPLE_FMT_NONE },
     .priv_class     = &aacenc_class,
@@ -110,6 +110,7 @@ typedef struct AACEncContext {
     const uint8_t *chan_map;                     ///< channel configuration map
 
     ChannelElement *cpe;                         ///< channel elements
+    struct AACEncContext *element_ctx;           ///< per channel element contexts for the quantizer search
     FFPsyContext psy;
     struct FFPsyPreprocessContext* psypp;
     AACCoefficientsEncoder *coder;
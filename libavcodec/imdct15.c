@@ -20,7 +20,7 @@
 
 /**
  * @file
- * Celt non-power of 2 iMDCT
+ * Celt non-power of 2 iMDCT and MDCT
  */
 
 #include <float.h>
@@ -86,6 +86,8 @@ av_cold void ff_imdct15_uninit(IMDCT15Context **ps)
 
 static void imdct15_half(IMDCT15Context *s, float *dst, const float *src,
                          ptrdiff_t stride, float scale);
+static void mdct15(IMDCT15Context *s, float *dst, const float *src,
+                   ptrdiff_t stride, float scale);
 
 av_cold int ff_imdct15_init(IMDCT15Context **ps, int N)
 {
@@ -135,6 +137,7 @@ av_cold int ff_imdct15_init(IMDCT15Context **ps, int N)
         s->exptab[0][j] = s->exptab[0][j - 15];
 
     s->imdct_half = imdct15_half;
+    s->mdct       = mdct15;
 
     if (ARCH_AARCH64)
         ff_imdct15_init_aarch64(s);
@@ -272,3 +275,46 @@ static void imdct15_half(IMDCT15Context *s, float *dst, const float *src,
         z[len8 + i].im     = scale * i1;
     }
 }
+
+/*
+ * The MDCT is the transpose of the iMDCT above: fold the windowed input into
+ * the middle half, then run the steps of imdct15_half() in reverse order,
+ * with the FFT done backwards by conjugating its input and output.
+ */
+static void mdct15(IMDCT15Context *s, float *dst, const float *src,
+                   ptrdiff_t stride, float scale)
+{
+    FFTComplex *z = s->tmp;
+    FFTComplex *t = s->tmp + s->len4;
+    const FFTComplex *tw = s->twiddle_exptab;
+    const int len2 = s->len2;
+    const int len4 = s->len4;
+    const int len8 = len4 / 2;
+    int i;
+
+#define FOLD(j) ((j) < len4 ? src[len4 + (j)] - src[len4 - 1 - (j)]             \
+                            : src[len4 + (j)] + src[2 * len2 + len4 - 1 - (j)])
+
+    for (i = 0; i < len8; i++) {
+        const int p = len8 - i - 1;
+        const int q = len8 + i;
+        float r0 = FOLD(2 * p), i0 = FOLD(2 * p + 1);
+        float r1 = FOLD(2 * q), i1 = FOLD(2 * q + 1);
+
+        z[p].re =   tw[p].im * i1 - tw[p].re * r0;
+        z[p].im = -(tw[p].im * r0 + tw[p].re * i1);
+        z[q].re =   tw[q].im * i0 - tw[q].re * r1;
+        z[q].im = -(tw[q].im * r1 + tw[q].re * i0);
+    }
+#undef FOLD
+
+    fft_calc(s, t, z, s->fft_n, 1);
+
+    for (i = 0; i < len4; i++) {
+        FFTComplex tmp;
+
+        CMUL(tmp, t[i], tw[i]);
+        dst[(len2 - 1 - 2 * i) * stride] =  scale * tmp.re;
+        dst[(2 * i)            * stride] = -scale * tmp.im;
+    }
+}
@@ -39,15 +39,22 @@ typedef struct IMDCT15Context {
      */
     void (*imdct_half)(struct IMDCT15Context *s, float *dst, const float *src,
                        ptrdiff_t src_stride, float scale);
+
+    /**
+     * Calculate the forward MDCT of 2 * len2 samples, writing len2
+     * coefficients with the given stride
+     */
+    void (*mdct)(struct IMDCT15Context *s, float *dst, const float *src,
+                 ptrdiff_t dst_stride, float scale);
 } IMDCT15Context;
 
 /**
- * Init an iMDCT of the length 2 * 15 * (2^N)
+ * Init an (i)MDCT of the length 2 * 15 * (2^N)
  */
 int ff_imdct15_init(IMDCT15Context **s, int N);
 
 /**
- * Free an iMDCT.
+ * Free an (i)MDCT.
  */
 void ff_imdct15_uninit(IMDCT15Context **s);
 
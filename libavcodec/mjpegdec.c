@@ -46,6 +46,7 @@
 #include "tiff.h"
 #include "exif.h"
 #include "bytestream.h"
+#include "thread.h"
 
 
 static int build_vlc(VLC *vlc, const uint8_t *bits_table,
@@ -71,20 +72,68 @@ static int build_vlc(VLC *vlc, const uint8_t *bits_table,
                               huff_code, 2, 2, huff_sym, 2, 2, use_static);
 }
 
-static void build_basic_mjpeg_vlc(MJpegDecodeContext *s)
+/* build the VLCs of one table from raw_huffman_lengths/values */
+static int init_huffman_table(MJpegDecodeContext *s, int class, int index)
 {
-    build_vlc(&s->vlcs[0][0], avpriv_mjpeg_bits_dc_luminance,
-              avpriv_mjpeg_val_dc, 12, 0, 0);
-    build_vlc(&s->vlcs[0][1], avpriv_mjpeg_bits_dc_chrominance,
-              avpriv_mjpeg_val_dc, 12, 0, 0);
-    build_vlc(&s->vlcs[1][0], avpriv_mjpeg_bits_ac_luminance,
-              avpriv_mjpeg_val_ac_luminance, 251, 0, 1);
-    build_vlc(&s->vlcs[1][1], avpriv_mjpeg_bits_ac_chrominance,
-              avpriv_mjpeg_val_ac_chrominance, 251, 0, 1);
-    build_vlc(&s->vlcs[2][0], avpriv_mjpeg_bits_ac_luminance,
-              avpriv_mjpeg_val_ac_luminance, 251, 0, 0);
-    build_vlc(&s->vlcs[2][1], avpriv_mjpeg_bits_ac_chrominance,
-              avpriv_mjpeg_val_ac_chrominance, 251, 0, 0);
+    const uint8_t *bits_table = s->raw_huffman_lengths[class][index];
+    const uint8_t *val_table  = s->raw_huffman_values[class][index];
+    int i, n = 0, code_max = 0, ret;
+
+    for (i = 1; i <= 16; i++)
+        n += bits_table[i];
+    for (i = 0; i < n; i++)
+        code_max = FFMAX(code_max, val_table[i]);
+
+    /* build VLC and flush previous vlc if present */
+    ff_free_vlc(&s->vlcs[class][index]);
+    av_log(s->avctx, AV_LOG_DEBUG, "class=%d index=%d nb_codes=%d\n",
+           class, index, code_max + 1);
+    if ((ret = build_vlc(&s->vlcs[class][index], bits_table, val_table,
+                         code_max + 1, 0, class > 0)) < 0)
+        return ret;
+
+    if (class > 0) {
+        ff_free_vlc(&s->vlcs[2][index]);
+        if ((ret = build_vlc(&s->vlcs[2][index], bits_table, val_table,
+                             code_max + 1, 0, 0)) < 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int init_default_huffman_tables(MJpegDecodeContext *s)
+{
+    static const struct {
+        int class;
+        int index;
+        const uint8_t *bits;
+        const uint8_t *values;
+    } ht[] = {
+        { 0, 0, avpriv_mjpeg_bits_dc_luminance,
+                avpriv_mjpeg_val_dc },
+        { 0, 1, avpriv_mjpeg_bits_dc_chrominance,
+                avpriv_mjpeg_val_dc },
+        { 1, 0, avpriv_mjpeg_bits_ac_luminance,
+                avpriv_mjpeg_val_ac_luminance },
+        { 1, 1, avpriv_mjpeg_bits_ac_chrominance,
+                avpriv_mjpeg_val_ac_chrominance },
+    };
+    int i, j, n, ret;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(ht); i++) {
+        uint8_t *lengths = s->raw_huffman_lengths[ht[i].class][ht[i].index];
+        uint8_t *values  = s->raw_huffman_values[ht[i].class][ht[i].index];
+
+        for (j = 1, n = 0; j <= 16; j++)
+            n += ht[i].bits[j];
+        memcpy(lengths + 1, ht[i].bits + 1, 16);
+        memcpy(values, ht[i].values, n);
+        memset(values + n, 0, 256 - n);
+
+        if ((ret = init_huffman_table(s, ht[i].class, ht[i].index)) < 0)
+            return ret;
+    }
+    return 0;
 }
 
 static void parse_avid(MJpegDecodeContext *s, uint8_t *buf, int len)
@@ -110,6 +159,7 @@ static void init_idct(AVCodecContext *avctx)
 av_cold int ff_mjpeg_decode_init(AVCodecContext *avctx)
 {
     MJpegDecodeContext *s = avctx->priv_data;
+    int ret;
 
     if (!s->picture_ptr) {
         s->picture = av_frame_alloc();
@@ -131,7 +181,8 @@ av_cold int ff_mjpeg_decode_init(AVCodecContext *avctx)
     avctx->chroma_sample_location = AVCHROMA_LOC_CENTER;
     avctx->colorspace = AVCOL_SPC_BT470BG;
 
-    build_basic_mjpeg_vlc(s);
+    if ((ret = init_default_huffman_tables(s)) < 0)
+        return ret;
 
     if (s->extern_huff) {
         av_log(avctx, AV_LOG_INFO, "using external huffman table\n");
@@ -139,7 +190,8 @@ av_cold int ff_mjpeg_decode_init(AVCodecContext *avctx)
         if (ff_mjpeg_decode_dht(s)) {
             av_log(avctx, AV_LOG_ERROR,
                    "error using external huffman table, switching back to internal\n");
-            build_basic_mjpeg_vlc(s);
+            if ((ret = init_default_huffman_tables(s)) < 0)
+                return ret;
         }
     }
     if (avctx->field_order == AV_FIELD_BB) { /* quicktime icefloe 019 */
@@ -203,7 +255,7 @@ int ff_mjpeg_decode_dqt(MJpegDecodeContext *s)
 /* decode huffman tables and build VLC decoders */
 int ff_mjpeg_decode_dht(MJpegDecodeContext *s)
 {
-    int len, index, i, class, n, v, code_max;
+    int len, index, i, class, n;
     uint8_t bits_table[17];
     uint8_t val_table[256];
     int ret = 0;
@@ -233,29 +285,16 @@ int ff_mjpeg_decode_dht(MJpegDecodeContext *s)
         if (len < n || n > 256)
             return AVERROR_INVALIDDATA;
 
-        code_max = 0;
-        for (i = 0; i < n; i++) {
-            v = get_bits(&s->gb, 8);
-            if (v > code_max)
-                code_max = v;
-            val_table[i] = v;
-        }
+        for (i = 0; i < n; i++)
+            val_table[i] = get_bits(&s->gb, 8);
         len -= n;
 
-        /* build VLC and flush previous vlc if present */
-        ff_free_vlc(&s->vlcs[class][index]);
-        av_log(s->avctx, AV_LOG_DEBUG, "class=%d index=%d nb_codes=%d\n",
-               class, index, code_max + 1);
-        if ((ret = build_vlc(&s->vlcs[class][index], bits_table, val_table,
-                             code_max + 1, 0, class > 0)) < 0)
-            return ret;
+        memcpy(s->raw_huffman_lengths[class][index] + 1, bits_table + 1, 16);
+        memcpy(s->raw_huffman_values[class][index], val_table, n);
+        memset(s->raw_huffman_values[class][index] + n, 0, 256 - n);
 
-        if (class > 0) {
-            ff_free_vlc(&s->vlcs[2][index]);
-            if ((ret = build_vlc(&s->vlcs[2][index], bits_table, val_table,
-                                 code_max + 1, 0, 0)) < 0)
-                return ret;
-        }
+        if ((ret = init_huffman_table(s, class, index)) < 0)
+            return ret;
     }
     return 0;
 }
@@ -264,6 +303,7 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
 {
     int len, nb_components, i, width, height, bits, ret;
     unsigned pix_fmt_id;
+    ThreadFrame tframe = { 0 };
     int h_count[MAX_COMPONENTS] = { 0 };
     int v_count[MAX_COMPONENTS] = { 0 };
 
@@ -620,8 +660,9 @@ unk_pixfmt:
         return 0;
     }
 
-    av_frame_unref(s->picture_ptr);
-    if (ff_get_buffer(s->avctx, s->picture_ptr, AV_GET_BUFFER_FLAG_REF) < 0)
+    tframe.f = s->picture_ptr;
+    ff_thread_release_buffer(s->avctx, &tframe);
+    if (ff_thread_get_buffer(s->avctx, &tframe, AV_GET_BUFFER_FLAG_REF) < 0)
         return -1;
     s->picture_ptr->pict_type = AV_PICTURE_TYPE_I;
     s->picture_ptr->key_frame = 1;
@@ -2057,6 +2098,27 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
     return start_code;
 }
 
+/**
+ * Find the end of the last marker in the packet that changes decoder state
+ * kept for the following frames: tables, frame headers, APPn and COM.
+ * With frame threading, the next frame may only start once it is parsed.
+ */
+static const uint8_t *find_last_header_marker(const uint8_t *buf,
+                                              const uint8_t *buf_end)
+{
+    const uint8_t *ptr = buf, *last = buf;
+
+    while (buf_end - ptr > 1 && (ptr = memchr(ptr, 0xff, buf_end - ptr - 1))) {
+        int code = *++ptr;
+
+        if ((code >= SOF0 && code <= SOF3) || code == SOF48 ||
+            code == DHT || code == DQT || code == LSE   ||
+            (code >= APP0 && code <= APP15) || code == COM)
+            last = ptr + 1;
+    }
+    return last;
+}
+
 int ff_mjpeg_decode_frame(AVCodecContext *avctx, void *data, int *got_frame,
                           AVPacket *avpkt)
 {
@@ -2066,6 +2128,7 @@ int ff_mjpeg_decode_frame(AVCodecContext *avctx, void *data, int *got_frame,
     MJpegDecodeContext *s = avctx->priv_data;
     const uint8_t *buf_end, *buf_ptr;
     const uint8_t *unescaped_buf_ptr;
+    const uint8_t *setup_end = NULL;
     int hshift, vshift;
     int unescaped_buf_size;
     int start_code;
@@ -2079,6 +2142,8 @@ int ff_mjpeg_decode_frame(AVCodecContext *avctx, void *data, int *got_frame,
 
     buf_ptr = buf;
     buf_end = buf + buf_size;
+    if (avctx->active_thread_type & FF_THREAD_FRAME)
+        setup_end = find_last_header_marker(buf, buf_end);
     while (buf_ptr < buf_end) {
         /* find start next marker */
         start_code = ff_mjpeg_find_marker(s, &buf_ptr, buf_end,
@@ -2242,6 +2307,14 @@ eoi_parser:
             if (avctx->skip_frame == AVDISCARD_ALL)
                 break;
 
+            /* The next frame can start once all headers are parsed. The
+             * fields of an interlaced frame share one picture and are
+             * decoded in order. */
+            if (setup_end && buf_ptr > setup_end && !s->interlaced) {
+                ff_thread_finish_setup(avctx);
+                setup_end = NULL;
+            }
+
             if ((ret = ff_mjpeg_decode_sos(s, NULL, 0, NULL)) < 0 &&
                 (avctx->err_recognition & AV_EF_EXPLODE))
                 goto fail;
@@ -2512,6 +2585,114 @@ static void decode_flush(AVCodecContext *avctx)
 }
 
 #if CONFIG_MJPEG_DECODER
+#if HAVE_THREADS
+static int decode_init_thread_copy(AVCodecContext *avctx)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    int class, index, i, n, ret;
+
+    /* the copied pointers are owned by the first thread */
+    s->avctx             = avctx;
+    s->buffer            = NULL;
+    s->buffer_size       = 0;
+    s->ljpeg_buffer      = NULL;
+    s->ljpeg_buffer_size = 0;
+    s->exif_metadata     = NULL;
+    s->stereo3d          = NULL;
+    memset(s->vlcs,     0, sizeof(s->vlcs));
+    memset(s->blocks,   0, sizeof(s->blocks));
+    memset(s->last_nnz, 0, sizeof(s->last_nnz));
+
+    s->picture = av_frame_alloc();
+    if (!s->picture)
+        return AVERROR(ENOMEM);
+    s->picture_ptr = s->picture;
+
+    for (class = 0; class < 2; class++) {
+        for (index = 0; index < 4; index++) {
+            for (i = 1, n = 0; i <= 16; i++)
+                n += s->raw_huffman_lengths[class][index][i];
+            if (n && (ret = init_huffman_table(s, class, index)) < 0)
+                return ret;
+        }
+    }
+    return 0;
+}
+
+static int decode_update_thread_context(AVCodecContext *dst,
+                                        const AVCodecContext *src)
+{
+    MJpegDecodeContext *s  = dst->priv_data;
+    MJpegDecodeContext *s1 = src->priv_data;
+    ThreadFrame tframe = { .f = s->picture_ptr };
+    int class, index, ret;
+
+    if (dst == src)
+        return 0;
+
+    /* tables can be left out of the following frames */
+    memcpy(s->quant_matrixes, s1->quant_matrixes, sizeof(s->quant_matrixes));
+    memcpy(s->qscale,         s1->qscale,         sizeof(s->qscale));
+    for (class = 0; class < 2; class++) {
+        for (index = 0; index < 4; index++) {
+            if (!memcmp(s->raw_huffman_lengths[class][index],
+                        s1->raw_huffman_lengths[class][index],
+                        sizeof(s->raw_huffman_lengths[class][index])) &&
+                !memcmp(s->raw_huffman_values[class][index],
+                        s1->raw_huffman_values[class][index],
+                        sizeof(s->raw_huffman_values[class][index])))
+                continue;
+            memcpy(s->raw_huffman_lengths[class][index],
+                   s1->raw_huffman_lengths[class][index],
+                   sizeof(s->raw_huffman_lengths[class][index]));
+            memcpy(s->raw_huffman_values[class][index],
+                   s1->raw_huffman_values[class][index],
+                   sizeof(s->raw_huffman_values[class][index]));
+            if ((ret = init_huffman_table(s, class, index)) < 0)
+                return ret;
+        }
+    }
+
+    /* frame header state the next SOF is compared against */
+    s->width  = s1->width;
+    s->height = s1->height;
+    s->bits   = s1->bits;
+    memcpy(s->h_count, s1->h_count, sizeof(s->h_count));
+    memcpy(s->v_count, s1->v_count, sizeof(s->v_count));
+    s->first_picture      = s1->first_picture;
+    s->interlaced         = s1->interlaced;
+    s->bottom_field       = s1->bottom_field;
+    s->interlace_polarity = s1->interlace_polarity;
+    s->rgb                = s1->rgb;
+    s->rct                = s1->rct;
+    s->pegasus_rct        = s1->pegasus_rct;
+    s->colr               = s1->colr;
+    s->xfrm               = s1->xfrm;
+    s->palette_index      = s1->palette_index;
+    s->buggy_avid         = s1->buggy_avid;
+    s->cs_itu601          = s1->cs_itu601;
+    s->multiscope         = s1->multiscope;
+    s->pix_desc           = s1->pix_desc;
+    s->idsp               = s1->idsp;
+    s->scantable          = s1->scantable;
+
+    /* The second field of an interlaced frame may come in the next packet.
+     * Interlaced input never finishes setup early, so the source thread is
+     * done with the picture by now. */
+    s->got_picture = 0;
+    if (s1->got_picture && s1->interlaced && s1->picture_ptr->buf[0]) {
+        ff_thread_release_buffer(dst, &tframe);
+        if ((ret = av_frame_ref(s->picture_ptr, s1->picture_ptr)) < 0)
+            return ret;
+        memcpy(s->linesize, s1->linesize, sizeof(s->linesize));
+        s->nb_components = s1->nb_components;
+        s->got_picture   = 1;
+    }
+
+    return 0;
+}
+#endif
+
 #define OFFSET(x) offsetof(MJpegDecodeContext, x)
 #define VD AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_DECODING_PARAM
 static const AVOption options[] = {
@@ -2537,7 +2718,9 @@ AVCodec ff_mjpeg_decoder = {
     .close          = ff_mjpeg_decode_end,
     .decode         = ff_mjpeg_decode_frame,
     .flush          = decode_flush,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(decode_update_thread_context),
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
     .max_lowres     = 3,
     .priv_class     = &mjpegdec_class,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE |
@@ -33,6 +33,7 @@
 
 #include "avcodec.h"
 #include "get_bits.h"
+#include "opustab.h"
 
 #define MAX_FRAME_SIZE               1275
 #define MAX_FRAMES                   48
@@ -397,6 +398,66 @@ static av_always_inline unsigned int opus_rc_trimodel(OpusRangeCoder *rc, int qn
     return k;
 }
 
+static inline int16_t celt_cos(int16_t x)
+{
+    x = (MUL16(x, x) + 4096) >> 13;
+    x = (32767-x) + ROUND_MUL16(x, (-7651 + ROUND_MUL16(x, (8277 + ROUND_MUL16(-626, x)))));
+    return 1+x;
+}
+
+static inline int celt_log2tan(int isin, int icos)
+{
+    int lc, ls;
+    lc = opus_ilog(icos);
+    ls = opus_ilog(isin);
+    icos <<= 15 - lc;
+    isin <<= 15 - ls;
+    return (ls << 11) - (lc << 11) +
+           ROUND_MUL16(isin, ROUND_MUL16(isin, -2597) + 7932) -
+           ROUND_MUL16(icos, ROUND_MUL16(icos, -2597) + 7932);
+}
+
+static inline int celt_bits2pulses(const uint8_t *cache, int bits)
+{
+    // TODO: Find the size of cache and make it into an array in the parameters list
+    int i, low = 0, high;
+
+    high = cache[0];
+    bits--;
+
+    for (i = 0; i < 6; i++) {
+        int center = (low + high + 1) >> 1;
+        if (cache[center] >= bits)
+            high = center;
+        else
+            low = center;
+    }
+
+    return (bits - (low == 0 ? -1 : cache[low]) <= cache[high] - bits) ? low : high;
+}
+
+static inline int celt_pulses2bits(const uint8_t *cache, int pulses)
+{
+    // TODO: Find the size of cache and make it into an array in the parameters list
+   return (pulses == 0) ? 0 : cache[pulses] + 1;
+}
+
+static inline int celt_compute_qn(int N, int b, int offset, int pulse_cap,
+                                  int dualstereo)
+{
+    int qn, qb;
+    int N2 = 2 * N - 1;
+    if (dualstereo && N == 2)
+        N2--;
+
+    /* The upper limit ensures that in a stereo split with itheta==16384, we'll
+     * always have enough bits left over to code at least one pulse in the
+     * side; otherwise it would collapse, since it doesn't get folded. */
+    qb = FFMIN3(b - pulse_cap - (4 << 3), (b + N2 * offset) / N2, 8 << 3);
+    qn = (qb < (1 << 3 >> 1)) ? 1 : ((ff_celt_qn_exp2[qb & 0x7] >> (14 - (qb >> 3))) + 1) >> 1 << 1;
+    return qn;
+}
+
 int ff_opus_parse_packet(OpusPacket *pkt, const uint8_t *buf, int buf_size,
                          int self_delimited);
 
@@ -0,0 +1,1368 @@
+/*
+ * Opus encoder
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Opus encoder, CELT only
+ *
+ * Every packet holds a single 20 ms CELT frame of a constant size. Only long
+ * blocks are used, without postfilter, dynamic allocation or dual stereo, so
+ * the encoder mostly mirrors the bitstream decisions of opus_celt.c.
+ */
+
+#include "libavutil/float_dsp.h"
+#include "libavutil/intreadwrite.h"
+
+#include "audio_frame_queue.h"
+#include "avcodec.h"
+#include "bytestream.h"
+#include "imdct15.h"
+#include "internal.h"
+#include "opus.h"
+#include "opustab.h"
+
+#define OPUS_FRAME_SAMPLES  CELT_MAX_FRAME_SIZE            /* 20 ms */
+#define OPUS_TOC_CELT_FB20  (31 << 3)                      /* CELT FB 20 ms, code 0 */
+#define OPUS_MAX_FRAME_BITS (MAX_FRAME_SIZE << 3)
+
+/* duration of the 20 ms frames in units of short blocks, log2 */
+#define CELT_LM             CELT_MAX_LOG_BLOCKS
+
+#define CELT_PVQ_U(n, k) (ff_celt_pvq_u_row[FFMIN(n, k)][FFMAX(n, k)])
+#define CELT_PVQ_V(n, k) (CELT_PVQ_U(n, k) + CELT_PVQ_U(n, (k) + 1))
+
+enum CeltSpread {
+    CELT_SPREAD_NONE,
+    CELT_SPREAD_LIGHT,
+    CELT_SPREAD_NORMAL,
+    CELT_SPREAD_AGGRESSIVE
+};
+
+/* bitrates in kbps above which a band is no longer coded with intensity stereo */
+static const uint8_t celt_intensity_thresholds[CELT_MAX_BANDS] = {
+    1, 2, 3, 4, 5, 6, 7, 8, 16, 24, 36, 44, 50, 56, 62, 67, 72, 79, 88, 106, 134
+};
+
+typedef struct OpusRangeEncoder {
+    uint8_t *buf;
+    int size;
+    int offs;           ///< bytes of range coded data written from the start
+    int end_offs;       ///< bytes of raw bits written from the end
+    uint32_t end_window;
+    int end_bits;
+    uint32_t low;
+    uint32_t range;
+    int rem;            ///< last byte, held back for a possible carry, or -1
+    int ext;            ///< number of 0xFF bytes held back for a carry
+    int total_bits;
+} OpusRangeEncoder;
+
+typedef struct OpusEncContext {
+    AVCodecContext *avctx;
+    AudioFrameQueue afq;
+    AVFloatDSPContext *dsp;
+    IMDCT15Context *mdct;
+
+    int channels;
+    int frame_bytes;        ///< size of a CELT frame, without the TOC byte
+    int intensity;          ///< first band to use intensity stereo for
+    int frame_count;
+
+    /* state that only affects a single frame */
+    int framebits;
+    int spread;
+    int codedbands;
+    int intensitystereo;
+    int remaining;
+    int remaining2;
+    int fine_bits    [CELT_MAX_BANDS];
+    int fine_priority[CELT_MAX_BANDS];
+    int pulses       [CELT_MAX_BANDS];
+    float band_amp   [2][CELT_MAX_BANDS];   ///< linear band amplitudes
+    float band_log   [2][CELT_MAX_BANDS];   ///< log2 band amplitudes, without mean
+    float energy_err [2][CELT_MAX_BANDS];   ///< fine energy quantization error
+
+    /* state that must match the decoder across frames */
+    float energy[2][CELT_MAX_BANDS];        ///< quantized band energies
+    int prev_codedbands;
+
+    float preemph[2];
+    DECLARE_ALIGNED(32, float, history)[2][CELT_OVERLAP + OPUS_FRAME_SAMPLES];
+    DECLARE_ALIGNED(32, float, mdct_in)[2 * OPUS_FRAME_SAMPLES];
+    DECLARE_ALIGNED(32, float, coeffs)[2][OPUS_FRAME_SAMPLES];
+} OpusEncContext;
+
+/**
+ * Range encoder, the counterpart of the decoding functions in opus.h
+ */
+static void opus_rc_enc_init(OpusRangeEncoder *rc, uint8_t *buf, int size)
+{
+    rc->buf        = buf;
+    rc->size       = size;
+    rc->offs       = 0;
+    rc->end_offs   = 0;
+    rc->end_window = 0;
+    rc->end_bits   = 0;
+    rc->low        = 0;
+    rc->range      = 1u << 31;
+    rc->rem        = -1;
+    rc->ext        = 0;
+    rc->total_bits = 33;
+}
+
+static void opus_rc_enc_put_byte(OpusRangeEncoder *rc, int byte)
+{
+    if (rc->offs + rc->end_offs < rc->size)
+        rc->buf[rc->offs++] = byte;
+}
+
+static void opus_rc_enc_put_byte_end(OpusRangeEncoder *rc, int byte)
+{
+    if (rc->offs + rc->end_offs < rc->size)
+        rc->buf[rc->size - ++rc->end_offs] = byte;
+}
+
+static void opus_rc_enc_carry_out(OpusRangeEncoder *rc, int cbuf)
+{
+    if (cbuf == 0xFF) {
+        rc->ext++;
+    } else {
+        int carry = cbuf >> 8;
+
+        if (rc->rem >= 0)
+            opus_rc_enc_put_byte(rc, rc->rem + carry);
+        for (; rc->ext > 0; rc->ext--)
+            opus_rc_enc_put_byte(rc, (0xFF + carry) & 0xFF);
+        rc->rem = cbuf & 0xFF;
+    }
+}
+
+static av_always_inline void opus_rc_enc_normalize(OpusRangeEncoder *rc)
+{
+    while (rc->range <= 1 << 23) {
+        opus_rc_enc_carry_out(rc, rc->low >> 23);
+        rc->low          = (rc->low << 8) & ((1u << 31) - 1);
+        rc->range      <<= 8;
+        rc->total_bits  += 8;
+    }
+}
+
+static av_always_inline void opus_rc_enc_update(OpusRangeEncoder *rc,
+                                                unsigned int low,
+                                                unsigned int high,
+                                                unsigned int total)
+{
+    unsigned int scale = rc->range / total;
+
+    if (low) {
+        rc->low   += rc->range - scale * (total - low);
+        rc->range  = scale * (high - low);
+    } else {
+        rc->range -= scale * (total - high);
+    }
+    opus_rc_enc_normalize(rc);
+}
+
+/* counterpart of opus_rc_getsymbol() */
+static void opus_rc_enc_cdf(OpusRangeEncoder *rc, int val, const uint16_t *cdf)
+{
+    opus_rc_enc_update(rc, val ? cdf[val] : 0, cdf[val + 1], cdf[0]);
+}
+
+/* counterpart of opus_rc_p2model() */
+static void opus_rc_enc_log(OpusRangeEncoder *rc, int val, unsigned int bits)
+{
+    unsigned int scale = rc->range >> bits;
+
+    if (val) {
+        rc->low  += rc->range - scale;
+        rc->range = scale;
+    } else {
+        rc->range -= scale;
+    }
+    opus_rc_enc_normalize(rc);
+}
+
+/* counterpart of opus_getrawbits() */
+static void opus_rc_put_raw(OpusRangeEncoder *rc, unsigned int val, int count)
+{
+    if (rc->end_bits + count > 32) {
+        while (rc->end_bits >= 8) {
+            opus_rc_enc_put_byte_end(rc, rc->end_window & 0xFF);
+            rc->end_window >>= 8;
+            rc->end_bits    -= 8;
+        }
+    }
+    rc->end_window |= val << rc->end_bits;
+    rc->end_bits   += count;
+    rc->total_bits += count;
+}
+
+/* counterpart of opus_rc_unimodel() */
+static void opus_rc_enc_uint(OpusRangeEncoder *rc, unsigned int val, unsigned int size)
+{
+    int bits = opus_ilog(size - 1);
+
+    if (bits > 8) {
+        unsigned int total = ((size - 1) >> (bits - 8)) + 1;
+        unsigned int k     = val >> (bits - 8);
+
+        opus_rc_enc_update(rc, k, k + 1, total);
+        opus_rc_put_raw(rc, val & ((1 << (bits - 8)) - 1), bits - 8);
+    } else {
+        opus_rc_enc_update(rc, val, val + 1, size);
+    }
+}
+
+/* counterpart of opus_rc_laplace(), may reduce the magnitude of *value */
+static void opus_rc_enc_laplace(OpusRangeEncoder *rc, int *value,
+                                unsigned int symbol, int decay)
+{
+    int val = *value;
+    unsigned int low = 0;
+
+    if (val) {
+        int s = -(val < 0);
+        int i;
+
+        val    = (val + s) ^ s;
+        low    = symbol;
+        symbol = (32768 - 32 - symbol) * (16384 - decay) >> 15;
+
+        for (i = 1; symbol > 0 && i < val; i++) {
+            symbol <<= 1;
+            low     += symbol + 2;
+            symbol   = symbol * decay >> 15;
+        }
+
+        if (!symbol) {
+            int di, ndi_max;
+
+            ndi_max = (32768 - low + 1 - 1) >> 0;
+            ndi_max = (ndi_max - s) >> 1;
+            di      = FFMIN(val - i, ndi_max - 1);
+            low    += (2 * di + 1 + s);
+            symbol  = FFMIN(1, 32768 - low);
+            *value  = (i + di + s) ^ s;
+        } else {
+            symbol += 1;
+            low    += symbol & ~s;
+        }
+    }
+    opus_rc_enc_update(rc, low, low + symbol, 32768);
+}
+
+/* counterpart of opus_rc_stepmodel() */
+static void opus_rc_enc_step(OpusRangeEncoder *rc, unsigned int val, int k0)
+{
+    unsigned int total = (k0 + 1) * 3 + k0;
+
+    opus_rc_enc_update(rc, (val <= k0) ? 3 * (val + 0) : (val - 1 - k0) + 3 * (k0 + 1),
+                       (val <= k0) ? 3 * (val + 1) : (val - 0 - k0) + 3 * (k0 + 1),
+                       total);
+}
+
+/* counterpart of opus_rc_trimodel() */
+static void opus_rc_enc_tri(OpusRangeEncoder *rc, unsigned int val, int qn)
+{
+    unsigned int total = ((qn >> 1) + 1) * ((qn >> 1) + 1);
+    unsigned int low, symbol;
+
+    if (val <= qn >> 1) {
+        low    = val * (val + 1) >> 1;
+        symbol = val + 1;
+    } else {
+        low    = total - ((qn + 1 - val) * (qn + 2 - val) >> 1);
+        symbol = qn + 1 - val;
+    }
+    opus_rc_enc_update(rc, low, low + symbol, total);
+}
+
+static av_always_inline int opus_rc_enc_tell(const OpusRangeEncoder *rc)
+{
+    return rc->total_bits - av_log2(rc->range) - 1;
+}
+
+static av_always_inline int opus_rc_enc_tell_frac(const OpusRangeEncoder *rc)
+{
+    unsigned int i, total_bits, rcbuffer, range;
+
+    total_bits = rc->total_bits << 3;
+    rcbuffer   = av_log2(rc->range) + 1;
+    range      = rc->range >> (rcbuffer - 16);
+
+    for (i = 0; i < 3; i++) {
+        int bit;
+        range = range * range >> 15;
+        bit = range >> 16;
+        rcbuffer = rcbuffer << 1 | bit;
+        range >>= bit;
+    }
+
+    return total_bits - rcbuffer;
+}
+
+/**
+ * Flush the range coder and the raw bits, filling the frame with zeroes
+ * in between.
+ */
+static void opus_rc_enc_end(OpusRangeEncoder *rc)
+{
+    uint32_t mask, end;
+    int bits = 32 - av_log2(rc->range) - 1;
+
+    mask = ((1u << 31) - 1) >> bits;
+    end  = (rc->low + mask) & ~mask;
+    if ((end | mask) >= rc->low + rc->range) {
+        bits++;
+        mask >>= 1;
+        end    = (rc->low + mask) & ~mask;
+    }
+    while (bits > 0) {
+        opus_rc_enc_carry_out(rc, end >> 23);
+        end   = (end << 8) & ((1u << 31) - 1);
+        bits -= 8;
+    }
+    if (rc->rem >= 0 || rc->ext > 0)
+        opus_rc_enc_carry_out(rc, 0);
+
+    while (rc->end_bits >= 8) {
+        opus_rc_enc_put_byte_end(rc, rc->end_window & 0xFF);
+        rc->end_window >>= 8;
+        rc->end_bits    -= 8;
+    }
+
+    memset(rc->buf + rc->offs, 0, rc->size - rc->offs - rc->end_offs);
+    if (rc->end_bits > 0 && rc->end_offs < rc->size) {
+        if (rc->offs + rc->end_offs >= rc->size && -bits < rc->end_bits)
+            rc->end_window &= (1 << -bits) - 1;
+        rc->buf[rc->size - rc->end_offs - 1] |= rc->end_window;
+    }
+}
+
+/**
+ * Preemphasize and window the input of a channel, then compute its MDCT
+ * and band energies, and normalize the bands.
+ */
+static void celt_analyze_channel(OpusEncContext *s, int ch, const float *samples,
+                                 int nb_samples)
+{
+    float *hist = s->history[ch];
+    float *in   = s->mdct_in + (OPUS_FRAME_SAMPLES - CELT_OVERLAP) / 2;
+    float *X    = s->coeffs[ch];
+    float m     = s->preemph[ch];
+    int i, j;
+
+    memcpy(hist, hist + OPUS_FRAME_SAMPLES, CELT_OVERLAP * sizeof(*hist));
+    for (i = 0; i < nb_samples; i++) {
+        float x = samples[i] * 32768.0f;
+        hist[CELT_OVERLAP + i] = x - m;
+        m = x * CELT_DEEMPH_COEFF;
+    }
+    for (; i < OPUS_FRAME_SAMPLES; i++) {
+        hist[CELT_OVERLAP + i] = -m;
+        m = 0.0f;
+    }
+    s->preemph[ch] = m;
+
+    /* the window is flat except for the overlap with the adjacent frames */
+    for (i = 0; i < CELT_OVERLAP; i++) {
+        in[i]                      = hist[i] * ff_celt_window[i];
+        in[OPUS_FRAME_SAMPLES + i] = hist[OPUS_FRAME_SAMPLES + i] *
+                                     ff_celt_window[CELT_OVERLAP - 1 - i];
+    }
+    memcpy(in + CELT_OVERLAP, hist + CELT_OVERLAP,
+           (OPUS_FRAME_SAMPLES - CELT_OVERLAP) * sizeof(*in));
+
+    s->mdct->mdct(s->mdct, X, s->mdct_in, 1, 1.0f / (OPUS_FRAME_SAMPLES / 2));
+
+    for (i = 0; i < CELT_MAX_BANDS; i++) {
+        float *band = X + (ff_celt_freq_bands[i] << CELT_LM);
+        int len     = ff_celt_freq_range[i] << CELT_LM;
+        float amp   = sqrtf(s->dsp->scalarproduct_float(band, band, len) + 1e-27f);
+
+        s->band_amp[ch][i] = amp;
+        s->band_log[ch][i] = log2f(amp) - ff_celt_mean_energy[i];
+        s->dsp->vector_fmul_scalar(band, band, 1.0f / amp, len);
+    }
+    for (j = ff_celt_freq_bands[CELT_MAX_BANDS] << CELT_LM; j < OPUS_FRAME_SAMPLES; j++)
+        X[j] = 0.0f;
+}
+
+static void celt_enc_coarse_energy(OpusEncContext *s, OpusRangeEncoder *rc)
+{
+    int i, j, intra = 0;
+    float prev[2] = { 0 };
+    float alpha, beta, max_decay;
+    const uint8_t *model;
+
+    /* only the first frame is intra coded, there is no packet loss to
+     * recover from in a file */
+    if (opus_rc_enc_tell(rc) + 3 <= s->framebits) {
+        intra = !s->frame_count;
+        opus_rc_enc_log(rc, intra, 3);
+    }
+
+    if (intra) {
+        alpha = 0;
+        beta  = 1.0f - 4915.0f/32768.0f;
+        model = ff_celt_coarse_energy_dist[CELT_LM][1];
+    } else {
+        alpha = ff_celt_alpha_coef[CELT_LM];
+        beta  = 1.0f - ff_celt_beta_coef[CELT_LM];
+        model = ff_celt_coarse_energy_dist[CELT_LM][0];
+    }
+
+    max_decay = FFMIN(16.0f, 0.125f * s->frame_bytes);
+
+    for (i = 0; i < CELT_MAX_BANDS; i++) {
+        for (j = 0; j < s->channels; j++) {
+            float bound = FFMAX(-28.0f, s->energy[j][i]) - max_decay;
+            float old   = FFMAX(-9.0f, s->energy[j][i]);
+            float error = s->band_log[j][i] - alpha * old - prev[j];
+            int budget  = s->framebits - opus_rc_enc_tell(rc);
+            int left    = budget - 3 * s->channels * (CELT_MAX_BANDS - i);
+            int value   = lrintf(floorf(0.5f + error));
+
+            /* do not let the energy decay faster than the decoder would */
+            if (value < 0 && s->band_log[j][i] < bound) {
+                value += (int)(bound - s->band_log[j][i]);
+                value  = FFMIN(value, 0);
+            }
+
+            /* keep enough bits to code the remaining bands */
+            if (i && left < 30) {
+                if (left < 24)
+                    value = FFMIN(1, value);
+                if (left < 16)
+                    value = FFMAX(-1, value);
+            }
+
+            if (budget >= 15) {
+                int k = FFMIN(i, 20) << 1;
+                opus_rc_enc_laplace(rc, &value, model[k] << 7, model[k + 1] << 6);
+            } else if (budget >= 2) {
+                value = av_clip(value, -1, 1);
+                opus_rc_enc_cdf(rc, 2 * value ^ -(value < 0), ff_celt_model_energy_small);
+            } else if (budget >= 1) {
+                value = FFMIN(value, 0);
+                opus_rc_enc_log(rc, -value, 1);
+            } else {
+                value = -1;
+            }
+
+            s->energy_err[j][i] = error - value;
+            s->energy[j][i]     = old * alpha + prev[j] + value;
+            prev[j]            += beta * value;
+        }
+    }
+}
+
+static void celt_enc_tf_changes(OpusEncContext *s, OpusRangeEncoder *rc)
+{
+    int i, consumed, tf_select_bit, bits = 4;
+
+    /* keep the time-frequency resolution of the long blocks in every band;
+     * tf_select then maps to no change either way and is not coded */
+    consumed      = opus_rc_enc_tell(rc);
+    tf_select_bit = consumed + bits + 1 <= s->framebits;
+    for (i = 0; i < CELT_MAX_BANDS; i++) {
+        if (consumed + bits + tf_select_bit <= s->framebits) {
+            opus_rc_enc_log(rc, 0, bits);
+            consumed = opus_rc_enc_tell(rc);
+        }
+        bits = 5;
+    }
+}
+
+/**
+ * Signal the allocation parameters and compute the bit allocation,
+ * this mirrors celt_decode_allocation() step by step.
+ */
+static void celt_enc_allocation(OpusEncContext *s, OpusRangeEncoder *rc)
+{
+    int cap[CELT_MAX_BANDS];
+    int threshold[CELT_MAX_BANDS];
+    int bits1[CELT_MAX_BANDS];
+    int bits2[CELT_MAX_BANDS];
+    int trim_offset[CELT_MAX_BANDS];
+
+    const int channels = s->channels;
+    int skip_startband = 0;
+    int dynalloc       = 6;
+    int alloctrim      = 5;
+    int extrabits      = 0;
+
+    int skip_bit            = 0;
+    int intensitystereo_bit = 0;
+    int dualstereo_bit      = 0;
+
+    int remaining, bandbits;
+    int low, high, total, done;
+    int totalbits;
+    int consumed;
+    int i, j;
+
+    consumed = opus_rc_enc_tell(rc);
+
+    s->spread = CELT_SPREAD_NORMAL;
+    if (consumed + 4 <= s->framebits)
+        opus_rc_enc_cdf(rc, s->spread, ff_celt_model_spread);
+
+    for (i = 0; i < CELT_MAX_BANDS; i++) {
+        cap[i] = (ff_celt_static_caps[CELT_LM][channels - 1][i] + 64)
+                 * ff_celt_freq_range[i] << (channels - 1) << CELT_LM >> 2;
+    }
+
+    /* no band boost */
+    totalbits = s->framebits << 3;
+    consumed  = opus_rc_enc_tell_frac(rc);
+    for (i = 0; i < CELT_MAX_BANDS; i++) {
+        if (consumed + (dynalloc << 3) < totalbits && cap[i] > 0) {
+            opus_rc_enc_log(rc, 0, dynalloc);
+            consumed = opus_rc_enc_tell_frac(rc);
+        }
+    }
+
+    if (consumed + (6 << 3) <= totalbits)
+        opus_rc_enc_cdf(rc, alloctrim, ff_celt_model_alloc_trim);
+
+    /* long blocks only, so no anti-collapse bit */
+    totalbits = (s->framebits << 3) - opus_rc_enc_tell_frac(rc) - 1;
+
+    if (totalbits >= 1 << 3)
+        skip_bit = 1 << 3;
+    totalbits -= skip_bit;
+
+    if (channels == 2) {
+        intensitystereo_bit = ff_celt_log2_frac[CELT_MAX_BANDS];
+        if (intensitystereo_bit <= totalbits) {
+            totalbits -= intensitystereo_bit;
+            if (totalbits >= 1 << 3) {
+                dualstereo_bit = 1 << 3;
+                totalbits -= 1 << 3;
+            }
+        } else
+            intensitystereo_bit = 0;
+    }
+
+    for (i = 0; i < CELT_MAX_BANDS; i++) {
+        int trim     = alloctrim - 5 - CELT_LM;
+        int band     = ff_celt_freq_range[i] * (CELT_MAX_BANDS - i - 1);
+        int duration = CELT_LM + 3;
+        int scale    = duration + channels - 1;
+
+        threshold[i] = FFMAX(3 * ff_celt_freq_range[i] << duration >> 4,
+                             channels << 3);
+
+        trim_offset[i] = trim * (band << scale) >> 6;
+
+        if (ff_celt_freq_range[i] << CELT_LM == 1)
+            trim_offset[i] -= channels << 3;
+    }
+
+    low  = 1;
+    high = CELT_VECTORS - 1;
+    while (low <= high) {
+        int center = (low + high) >> 1;
+        done = total = 0;
+
+        for (i = CELT_MAX_BANDS - 1; i >= 0; i--) {
+            bandbits = ff_celt_freq_range[i] * ff_celt_static_alloc[center][i]
+                       << (channels - 1) << CELT_LM >> 2;
+
+            if (bandbits)
+                bandbits = FFMAX(0, bandbits + trim_offset[i]);
+
+            if (bandbits >= threshold[i] || done) {
+                done = 1;
+                total += FFMIN(bandbits, cap[i]);
+            } else if (bandbits >= channels << 3)
+                total += channels << 3;
+        }
+
+        if (total > totalbits)
+            high = center - 1;
+        else
+            low = center + 1;
+    }
+    high = low--;
+
+    for (i = 0; i < CELT_MAX_BANDS; i++) {
+        bits1[i] = ff_celt_freq_range[i] * ff_celt_static_alloc[low][i]
+                   << (channels - 1) << CELT_LM >> 2;
+        bits2[i] = high >= CELT_VECTORS ? cap[i] :
+                   ff_celt_freq_range[i] * ff_celt_static_alloc[high][i]
+                   << (channels - 1) << CELT_LM >> 2;
+
+        if (bits1[i])
+            bits1[i] = FFMAX(0, bits1[i] + trim_offset[i]);
+        if (bits2[i])
+            bits2[i] = FFMAX(0, bits2[i] + trim_offset[i]);
+
+        bits2[i] = FFMAX(0, bits2[i] - bits1[i]);
+    }
+
+    low  = 0;
+    high = 1 << CELT_ALLOC_STEPS;
+    for (i = 0; i < CELT_ALLOC_STEPS; i++) {
+        int center = (low + high) >> 1;
+        done = total = 0;
+
+        for (j = CELT_MAX_BANDS - 1; j >= 0; j--) {
+            bandbits = bits1[j] + (center * bits2[j] >> CELT_ALLOC_STEPS);
+
+            if (bandbits >= threshold[j] || done) {
+                done = 1;
+                total += FFMIN(bandbits, cap[j]);
+            } else if (bandbits >= channels << 3)
+                total += channels << 3;
+        }
+        if (total > totalbits)
+            high = center;
+        else
+            low = center;
+    }
+
+    done = total = 0;
+    for (i = CELT_MAX_BANDS - 1; i >= 0; i--) {
+        bandbits = bits1[i] + (low * bits2[i] >> CELT_ALLOC_STEPS);
+
+        if (bandbits >= threshold[i] || done)
+            done = 1;
+        else
+            bandbits = (bandbits >= channels << 3) ?
+                       channels << 3 : 0;
+
+        bandbits     = FFMIN(bandbits, cap[i]);
+        s->pulses[i] = bandbits;
+        total       += bandbits;
+    }
+
+    /* band skipping: keep the high bands only if they get enough bits
+     * per coefficient, with some hysteresis */
+    for (s->codedbands = CELT_MAX_BANDS; ; s->codedbands--) {
+        int allocation;
+        j = s->codedbands - 1;
+
+        if (j == skip_startband) {
+            totalbits += skip_bit;
+            break;
+        }
+
+        remaining   = totalbits - total;
+        bandbits    = remaining / (ff_celt_freq_bands[j+1] - ff_celt_freq_bands[0]);
+        remaining  -= bandbits  * (ff_celt_freq_bands[j+1] - ff_celt_freq_bands[0]);
+        allocation  = s->pulses[j] + bandbits * ff_celt_freq_range[j]
+                      + FFMAX(0, remaining - (ff_celt_freq_bands[j] - ff_celt_freq_bands[0]));
+
+        if (allocation >= FFMAX(threshold[j], (channels + 1) << 3)) {
+            int depth_threshold = 0;
+            int keep;
+
+            if (s->codedbands > 17)
+                depth_threshold = j < s->prev_codedbands ? 7 : 9;
+            keep = s->codedbands <= 2 ||
+                   allocation > (depth_threshold * ff_celt_freq_range[j] << CELT_LM << 3) >> 4;
+            opus_rc_enc_log(rc, keep, 1);
+            if (keep)
+                break;
+
+            total      += 1 << 3;
+            allocation -= 1 << 3;
+        }
+
+        total -= s->pulses[j];
+        if (intensitystereo_bit) {
+            total -= intensitystereo_bit;
+            intensitystereo_bit = ff_celt_log2_frac[j];
+            total += intensitystereo_bit;
+        }
+
+        total += s->pulses[j] = (allocation >= channels << 3) ?
+                                channels << 3 : 0;
+    }
+    s->prev_codedbands = s->codedbands;
+
+    /* never dual stereo */
+    s->intensitystereo = 0;
+    if (intensitystereo_bit) {
+        s->intensitystereo = FFMIN(s->intensity, s->codedbands);
+        opus_rc_enc_uint(rc, s->intensitystereo, s->codedbands + 1);
+    }
+    if (s->intensitystereo <= 0)
+        totalbits += dualstereo_bit;
+    else if (dualstereo_bit)
+        opus_rc_enc_log(rc, 0, 1);
+
+    remaining = totalbits - total;
+    bandbits  = remaining / (ff_celt_freq_bands[s->codedbands] - ff_celt_freq_bands[0]);
+    remaining -= bandbits * (ff_celt_freq_bands[s->codedbands] - ff_celt_freq_bands[0]);
+    for (i = 0; i < s->codedbands; i++) {
+        int bits = FFMIN(remaining, ff_celt_freq_range[i]);
+
+        s->pulses[i] += bits + bandbits * ff_celt_freq_range[i];
+        remaining    -= bits;
+    }
+
+    for (i = 0; i < s->codedbands; i++) {
+        int N = ff_celt_freq_range[i] << CELT_LM;
+        int prev_extra = extrabits;
+        s->pulses[i] += extrabits;
+
+        if (N > 1) {
+            int dof, temp, offset;
+            int fine_bits, max_bits;
+
+            extrabits = FFMAX(0, s->pulses[i] - cap[i]);
+            s->pulses[i] -= extrabits;
+
+            dof = N * channels + (channels == 2 && N > 2 && i < s->intensitystereo);
+            temp = dof * (ff_celt_log_freq_range[i] + (CELT_LM << 3));
+            offset = (temp >> 1) - dof * CELT_FINE_OFFSET;
+            if (N == 2)
+                offset += dof << 1;
+
+            if (s->pulses[i] + offset < 2 * (dof << 3))
+                offset += temp >> 2;
+            else if (s->pulses[i] + offset < 3 * (dof << 3))
+                offset += temp >> 3;
+
+            fine_bits = (s->pulses[i] + offset + (dof << 2)) / (dof << 3);
+            max_bits  = FFMIN((s->pulses[i] >> 3) >> (channels - 1),
+                              CELT_MAX_FINE_BITS);
+            max_bits  = FFMAX(max_bits, 0);
+
+            s->fine_bits[i]     = av_clip(fine_bits, 0, max_bits);
+            s->fine_priority[i] = (s->fine_bits[i] * (dof << 3) >= s->pulses[i] + offset);
+            s->pulses[i]       -= s->fine_bits[i] << (channels - 1) << 3;
+        } else {
+            extrabits = FFMAX(0, s->pulses[i] - (channels << 3));
+            s->pulses[i] -= extrabits;
+            s->fine_bits[i] = 0;
+            s->fine_priority[i] = 1;
+        }
+
+        if (extrabits > 0) {
+            int fineextra = FFMIN(extrabits >> (channels + 2),
+                                  CELT_MAX_FINE_BITS - s->fine_bits[i]);
+            s->fine_bits[i] += fineextra;
+
+            fineextra <<= channels + 2;
+            s->fine_priority[i] = (fineextra >= extrabits - prev_extra);
+            extrabits -= fineextra;
+        }
+    }
+    s->remaining = extrabits;
+
+    for (; i < CELT_MAX_BANDS; i++) {
+        s->fine_bits[i]     = s->pulses[i] >> (channels - 1) >> 3;
+        s->pulses[i]        = 0;
+        s->fine_priority[i] = s->fine_bits[i] < 1;
+    }
+}
+
+static void celt_enc_fine_energy(OpusEncContext *s, OpusRangeEncoder *rc)
+{
+    int i, j;
+
+    for (i = 0; i < CELT_MAX_BANDS; i++) {
+        int bits = s->fine_bits[i];
+
+        if (!bits)
+            continue;
+
+        for (j = 0; j < s->channels; j++) {
+            int q2 = av_clip((int)floorf((s->energy_err[j][i] + 0.5f) * (1 << bits)),
+                             0, (1 << bits) - 1);
+            float offset = (q2 + 0.5f) * (1 << (14 - bits)) / 16384.0f - 0.5f;
+
+            opus_rc_put_raw(rc, q2, bits);
+            s->energy[j][i]     += offset;
+            s->energy_err[j][i] -= offset;
+        }
+    }
+}
+
+static void celt_enc_final_energy(OpusEncContext *s, OpusRangeEncoder *rc)
+{
+    int bits_left = s->framebits - opus_rc_enc_tell(rc);
+    int priority, i, j;
+
+    for (priority = 0; priority < 2; priority++) {
+        for (i = 0; i < CELT_MAX_BANDS && bits_left >= s->channels; i++) {
+            if (s->fine_priority[i] != priority || s->fine_bits[i] >= CELT_MAX_FINE_BITS)
+                continue;
+
+            for (j = 0; j < s->channels; j++) {
+                int q2 = s->energy_err[j][i] >= 0;
+                float offset = (q2 - 0.5f) * (1 << (14 - s->fine_bits[i] - 1)) / 16384.0f;
+
+                opus_rc_put_raw(rc, q2, 1);
+                s->energy[j][i]     += offset;
+                s->energy_err[j][i] -= offset;
+                bits_left--;
+            }
+        }
+    }
+}
+
+/* the inverse of the rotation applied by celt_exp_rotation() in the decoder */
+static void celt_exp_rotation1(float *X, int len, int stride, float c, float s)
+{
+    float *Xptr;
+    int i;
+
+    Xptr = X;
+    for (i = 0; i < len - stride; i++) {
+        float x1     = Xptr[0];
+        float x2     = Xptr[stride];
+        Xptr[stride] = c * x2 + s * x1;
+        *Xptr++      = c * x1 - s * x2;
+    }
+
+    Xptr = &X[len - 2 * stride - 1];
+    for (i = len - 2 * stride - 1; i >= 0; i--) {
+        float x1     = Xptr[0];
+        float x2     = Xptr[stride];
+        Xptr[stride] = c * x2 + s * x1;
+        *Xptr--      = c * x1 - s * x2;
+    }
+}
+
+static void celt_exp_rotation(float *X, int len, int K, int spread)
+{
+    int stride2 = 0;
+    float gain, theta, c, s;
+
+    if (2 * K >= len || spread == CELT_SPREAD_NONE)
+        return;
+
+    gain  = (float)len / (len + (20 - 5 * spread) * K);
+    theta = M_PI * gain * gain / 4;
+    c     = cosf(theta);
+    s     = sinf(theta);
+
+    if (len >= 8) {
+        stride2 = 1;
+        while (stride2 * stride2 + stride2 < len)
+            stride2++;
+    }
+
+    celt_exp_rotation1(X, len, 1, c, -s);
+    if (stride2)
+        celt_exp_rotation1(X, len, stride2, s, -c);
+}
+
+/**
+ * Find the vector of K pulses closest in direction to X: project X on the
+ * pyramid, then add the remaining pulses one at a time where they increase
+ * the normalized correlation the most.
+ */
+static void celt_pvq_search(float *X, int *y, int K, int N)
+{
+    float xy = 0.0f, yy = 0.0f, sum = 0.0f;
+    int pulses = K;
+    int i, j;
+
+    for (j = 0; j < N; j++) {
+        y[j] = 0;
+        sum += fabsf(X[j]);
+    }
+
+    if (K > N >> 1 && sum > 1e-15f) {
+        float rcp = (K - 1) / sum;
+
+        for (j = 0; j < N; j++) {
+            y[j]    = (int)(fabsf(X[j]) * rcp);
+            xy     += fabsf(X[j]) * y[j];
+            yy     += y[j] * y[j];
+            pulses -= y[j];
+        }
+    }
+
+    if (sum <= 1e-15f) {
+        y[0]  += pulses;
+        pulses = 0;
+    }
+
+    for (i = 0; i < pulses; i++) {
+        float best_num = -1.0f, best_den = 1.0f;
+        int best = 0;
+
+        yy += 1.0f;
+        for (j = 0; j < N; j++) {
+            float num = xy + fabsf(X[j]);
+            float den = yy + 2.0f * y[j];
+
+            num *= num;
+            if (num * best_den > best_num * den) {
+                best_num = num;
+                best_den = den;
+                best     = j;
+            }
+        }
+
+        xy += fabsf(X[best]);
+        yy += 2.0f * y[best];
+        y[best]++;
+    }
+
+    for (j = 0; j < N; j++)
+        if (X[j] < 0)
+            y[j] = -y[j];
+}
+
+/* the index of a pulse vector, the inverse of celt_cwrsi() */
+static uint32_t celt_icwrs(int N, const int *y)
+{
+    uint32_t i;
+    int j = N - 1;
+    int k = FFABS(y[j]);
+
+    i = y[j] < 0;
+    do {
+        j--;
+        i += CELT_PVQ_U(N - j, k);
+        k += FFABS(y[j]);
+        if (y[j] < 0)
+            i += CELT_PVQ_U(N - j, k + 1);
+    } while (j > 0);
+
+    return i;
+}
+
+static void celt_alg_quant(OpusEncContext *s, OpusRangeEncoder *rc, float *X,
+                           int N, int K)
+{
+    int y[176];
+
+    celt_exp_rotation(X, N, K, s->spread);
+    celt_pvq_search(X, y, K, N);
+    opus_rc_enc_uint(rc, celt_icwrs(N, y), CELT_PVQ_V(N, K));
+}
+
+/* the split angle of a band in Q14, from 0 for mid only to 16384 for side only */
+static int celt_band_theta(const float *X, const float *Y, int N, int stereo)
+{
+    float emid = 1e-15f, eside = 1e-15f;
+    int i;
+
+    if (stereo) {
+        for (i = 0; i < N; i++) {
+            float m = 0.5f * (X[i] + Y[i]);
+            float d = 0.5f * (X[i] - Y[i]);
+            emid  += m * m;
+            eside += d * d;
+        }
+    } else {
+        for (i = 0; i < N; i++) {
+            emid  += X[i] * X[i];
+            eside += Y[i] * Y[i];
+        }
+    }
+
+    return lrintf(floorf(0.5f + 16384 * 0.63662f * atan2f(sqrtf(eside), sqrtf(emid))));
+}
+
+static void celt_intensity_stereo(OpusEncContext *s, float *X, const float *Y,
+                                  int band, int N)
+{
+    float left  = s->band_amp[0][band];
+    float right = s->band_amp[1][band];
+    float norm  = 1e-15f + sqrtf(1e-15f + left * left + right * right);
+    float a1    = left  / norm;
+    float a2    = right / norm;
+    int i;
+
+    for (i = 0; i < N; i++)
+        X[i] = a1 * X[i] + a2 * Y[i];
+}
+
+static void celt_stereo_split(float *X, float *Y, int N)
+{
+    int i;
+
+    for (i = 0; i < N; i++) {
+        float l = M_SQRT1_2 * X[i];
+        float r = M_SQRT1_2 * Y[i];
+        X[i] = l + r;
+        Y[i] = r - l;
+    }
+}
+
+/**
+ * Quantize a normalized band, this mirrors celt_decode_band() with a single
+ * long block and no time-frequency change. The coefficients are destroyed.
+ */
+static void celt_quant_band(OpusEncContext *s, OpusRangeEncoder *rc,
+                            const int band, float *X, float *Y, int N, int b,
+                            int duration)
+{
+    const uint8_t *cache;
+    int stereo = Y != NULL;
+    int split  = stereo;
+
+    if (N == 1) {
+        int i;
+        float *x = X;
+        for (i = 0; i <= stereo; i++) {
+            if (s->remaining2 >= 1 << 3) {
+                opus_rc_put_raw(rc, x[0] < 0, 1);
+                s->remaining2 -= 1 << 3;
+                b             -= 1 << 3;
+            }
+            x = Y;
+        }
+        return;
+    }
+
+    cache = ff_celt_cache_bits +
+            ff_celt_cache_index[(duration + 1) * CELT_MAX_BANDS + band];
+    if (!stereo && duration >= 0 && b > cache[cache[0]] + 12 && N > 2) {
+        N >>= 1;
+        Y = X + N;
+        split = 1;
+        duration -= 1;
+    }
+
+    if (split) {
+        int qn, itheta, inv = 0;
+        int imid, iside, delta;
+        int mbits, sbits, qalloc;
+        int pulse_cap, offset, tell;
+
+        pulse_cap = ff_celt_log_freq_range[band] + duration * 8;
+        offset = (pulse_cap >> 1) - (stereo && N == 2 ? CELT_QTHETA_OFFSET_TWOPHASE :
+                                                        CELT_QTHETA_OFFSET);
+        qn = (stereo && band >= s->intensitystereo) ? 1 :
+             celt_compute_qn(N, b, offset, pulse_cap, stereo);
+        itheta = celt_band_theta(X, Y, N, stereo);
+        tell = opus_rc_enc_tell_frac(rc);
+        if (qn != 1) {
+            itheta = (itheta * qn + 8192) >> 14;
+            if (stereo && N > 2)
+                opus_rc_enc_step(rc, itheta, qn / 2);
+            else if (stereo)
+                opus_rc_enc_uint(rc, itheta, qn + 1);
+            else
+                opus_rc_enc_tri(rc, itheta, qn);
+            itheta = itheta * 16384 / qn;
+
+            if (stereo) {
+                if (itheta == 0)
+                    celt_intensity_stereo(s, X, Y, band, N);
+                else
+                    celt_stereo_split(X, Y, N);
+            }
+        } else if (stereo) {
+            int j;
+
+            if (b > 2 << 3 && s->remaining2 > 2 << 3) {
+                inv = itheta > 8192;
+                opus_rc_enc_log(rc, inv, 2);
+            }
+            if (inv)
+                for (j = 0; j < N; j++)
+                    Y[j] = -Y[j];
+            celt_intensity_stereo(s, X, Y, band, N);
+            itheta = 0;
+        }
+        qalloc = opus_rc_enc_tell_frac(rc) - tell;
+        b -= qalloc;
+
+        if (itheta == 0) {
+            imid  = 32767;
+            iside = 0;
+            delta = -16384;
+        } else if (itheta == 16384) {
+            imid  = 0;
+            iside = 32767;
+            delta = 16384;
+        } else {
+            imid  = celt_cos(itheta);
+            iside = celt_cos(16384 - itheta);
+            delta = ROUND_MUL16((N - 1) << 7, celt_log2tan(iside, imid));
+        }
+
+        if (N == 2 && stereo) {
+            float *x2, *y2;
+
+            sbits = (itheta != 0 && itheta != 16384) ? 1 << 3 : 0;
+            mbits = b - sbits;
+            s->remaining2 -= qalloc + sbits;
+
+            x2 = itheta > 8192 ? Y : X;
+            y2 = itheta > 8192 ? X : Y;
+            if (sbits)
+                opus_rc_put_raw(rc, x2[0] * y2[1] - x2[1] * y2[0] < 0, 1);
+            celt_quant_band(s, rc, band, x2, NULL, N, mbits, duration);
+        } else {
+            int rebalance;
+
+            mbits = av_clip((b - delta) / 2, 0, b);
+            sbits = b - mbits;
+            s->remaining2 -= qalloc;
+
+            rebalance = s->remaining2;
+            if (mbits >= sbits) {
+                celt_quant_band(s, rc, band, X, NULL, N, mbits, duration);
+                rebalance = mbits - (rebalance - s->remaining2);
+                if (rebalance > 3 << 3 && itheta != 0)
+                    sbits += rebalance - (3 << 3);
+                celt_quant_band(s, rc, band, Y, NULL, N, sbits, duration);
+            } else {
+                celt_quant_band(s, rc, band, Y, NULL, N, sbits, duration);
+                rebalance = sbits - (rebalance - s->remaining2);
+                if (rebalance > 3 << 3 && itheta != 16384)
+                    mbits += rebalance - (3 << 3);
+                celt_quant_band(s, rc, band, X, NULL, N, mbits, duration);
+            }
+        }
+    } else {
+        unsigned int q         = celt_bits2pulses(cache, b);
+        unsigned int curr_bits = celt_pulses2bits(cache, q);
+        s->remaining2 -= curr_bits;
+
+        while (s->remaining2 < 0 && q > 0) {
+            s->remaining2 += curr_bits;
+            curr_bits      = celt_pulses2bits(cache, --q);
+            s->remaining2 -= curr_bits;
+        }
+
+        if (q != 0)
+            celt_alg_quant(s, rc, X, N, (q < 8) ? q : (8 + (q & 7)) << ((q >> 3) - 1));
+    }
+}
+
+static void celt_enc_bands(OpusEncContext *s, OpusRangeEncoder *rc)
+{
+    int totalbits = s->framebits << 3;
+    int i;
+
+    for (i = 0; i < CELT_MAX_BANDS; i++) {
+        int band_offset = ff_celt_freq_bands[i] << CELT_LM;
+        int band_size   = ff_celt_freq_range[i] << CELT_LM;
+        float *X = s->coeffs[0] + band_offset;
+        float *Y = s->channels == 2 ? s->coeffs[1] + band_offset : NULL;
+        int consumed = opus_rc_enc_tell_frac(rc);
+        int b = 0;
+
+        if (i)
+            s->remaining -= consumed;
+        s->remaining2 = totalbits - consumed - 1;
+        if (i <= s->codedbands - 1) {
+            int curr_balance = s->remaining / FFMIN(3, s->codedbands - i);
+            b = av_clip_uintp2(FFMIN(s->remaining2 + 1, s->pulses[i] + curr_balance), 14);
+        }
+
+        celt_quant_band(s, rc, i, X, Y, band_size, b, CELT_LM);
+
+        s->remaining += s->pulses[i] + consumed;
+    }
+}
+
+static void celt_encode_frame(OpusEncContext *s, uint8_t *buf, int silence)
+{
+    OpusRangeEncoder rc_buf, *rc = &rc_buf;
+    int consumed, i, j;
+
+    opus_rc_enc_init(rc, buf, s->frame_bytes);
+    s->framebits = s->frame_bytes << 3;
+
+    consumed = opus_rc_enc_tell(rc);
+    if (consumed == 1)
+        opus_rc_enc_log(rc, silence, 15);
+    else
+        silence = 1;
+
+    if (silence) {
+        rc->total_bits += s->framebits - opus_rc_enc_tell(rc);
+        for (i = 0; i < 2; i++)
+            for (j = 0; j < CELT_MAX_BANDS; j++)
+                s->energy[i][j] = CELT_ENERGY_SILENCE;
+    } else {
+        /* no postfilter */
+        if (consumed + 16 <= s->framebits) {
+            opus_rc_enc_log(rc, 0, 1);
+            consumed = opus_rc_enc_tell(rc);
+        }
+
+        /* no transient, i.e. a single long block */
+        if (consumed + 3 <= s->framebits)
+            opus_rc_enc_log(rc, 0, 3);
+
+        celt_enc_coarse_energy(s, rc);
+        celt_enc_tf_changes   (s, rc);
+        celt_enc_allocation   (s, rc);
+        celt_enc_fine_energy  (s, rc);
+        celt_enc_bands        (s, rc);
+        celt_enc_final_energy (s, rc);
+    }
+
+    opus_rc_enc_end(rc);
+    s->frame_count++;
+}
+
+static int opus_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
+                             const AVFrame *frame, int *got_packet_ptr)
+{
+    OpusEncContext *s = avctx->priv_data;
+    int silence = 1;
+    int ch, i, ret;
+
+    if (frame) {
+        if ((ret = ff_af_queue_add(&s->afq, frame)) < 0)
+            return ret;
+    } else if (!s->afq.remaining_samples) {
+        return 0;
+    }
+
+    for (ch = 0; ch < s->channels; ch++) {
+        const float *samples = frame ? (const float *)frame->extended_data[ch] : NULL;
+        int nb_samples       = frame ? frame->nb_samples : 0;
+
+        for (i = 0; i < nb_samples && silence; i++)
+            silence = samples[i] == 0.0f;
+        celt_analyze_channel(s, ch, samples, nb_samples);
+        for (i = 0; i < CELT_OVERLAP && silence; i++)
+            silence = s->history[ch][i] == 0.0f;
+    }
+
+    if ((ret = ff_alloc_packet2(avctx, avpkt, s->frame_bytes + 1, 0)) < 0)
+        return ret;
+
+    avpkt->data[0] = OPUS_TOC_CELT_FB20 | (s->channels == 2) << 2;
+    celt_encode_frame(s, avpkt->data + 1, silence);
+
+    ff_af_queue_remove(&s->afq, OPUS_FRAME_SAMPLES, &avpkt->pts, &avpkt->duration);
+    if (avpkt->duration < OPUS_FRAME_SAMPLES) {
+        uint8_t *side = av_packet_new_side_data(avpkt, AV_PKT_DATA_SKIP_SAMPLES, 10);
+        if (!side)
+            return AVERROR(ENOMEM);
+        AV_WL32(side + 4, OPUS_FRAME_SAMPLES - avpkt->duration);
+    }
+
+    *got_packet_ptr = 1;
+
+    return 0;
+}
+
+static av_cold int opus_encode_end(AVCodecContext *avctx)
+{
+    OpusEncContext *s = avctx->priv_data;
+
+    ff_imdct15_uninit(&s->mdct);
+    av_freep(&s->dsp);
+    ff_af_queue_close(&s->afq);
+    av_freep(&avctx->extradata);
+
+    return 0;
+}
+
+static av_cold int opus_encode_init(AVCodecContext *avctx)
+{
+    OpusEncContext *s = avctx->priv_data;
+    int64_t bit_rate;
+    uint8_t *p;
+    int i, ret;
+
+    s->avctx    = avctx;
+    s->channels = avctx->channels;
+
+    if (!avctx->bit_rate) {
+        avctx->bit_rate = 64000 * s->channels;
+        av_log(avctx, AV_LOG_WARNING, "No bit rate set. Defaulting to %"PRId64" bps.\n",
+               (int64_t)avctx->bit_rate);
+    }
+    /* one byte of the packet is the TOC */
+    bit_rate       = av_clip64(avctx->bit_rate, 6000 * s->channels, 255000 * s->channels);
+    s->frame_bytes = bit_rate * OPUS_FRAME_SAMPLES / (8 * 48000) - 1;
+    s->frame_bytes = FFMIN(s->frame_bytes, MAX_FRAME_SIZE);
+    bit_rate       = (s->frame_bytes + 1) * 8LL * 48000 / OPUS_FRAME_SAMPLES;
+    if (bit_rate != avctx->bit_rate)
+        av_log(avctx, AV_LOG_WARNING, "Using a bit rate of %"PRId64" bps instead of %"PRId64".\n",
+               bit_rate, (int64_t)avctx->bit_rate);
+    avctx->bit_rate = bit_rate;
+
+    s->intensity = CELT_MAX_BANDS;
+    if (s->channels == 2) {
+        for (i = 0; i < CELT_MAX_BANDS; i++)
+            if (bit_rate / 1000 < celt_intensity_thresholds[i])
+                break;
+        s->intensity = i;
+    }
+
+    avctx->frame_size      = OPUS_FRAME_SAMPLES;
+    avctx->initial_padding = CELT_OVERLAP;
+
+    avctx->extradata = av_mallocz(19 + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!avctx->extradata)
+        return AVERROR(ENOMEM);
+    avctx->extradata_size = 19;
+    p = avctx->extradata;
+    bytestream_put_buffer(&p, "OpusHead", 8);
+    bytestream_put_byte(&p, 1);
+    bytestream_put_byte(&p, s->channels);
+    bytestream_put_le16(&p, avctx->initial_padding);
+    bytestream_put_le32(&p, avctx->sample_rate);
+    bytestream_put_le16(&p, 0);
+    bytestream_put_byte(&p, 0);
+
+    if ((ret = ff_imdct15_init(&s->mdct, CELT_LM + 3)) < 0)
+        return ret;
+
+    s->dsp = avpriv_float_dsp_alloc(avctx->flags & AV_CODEC_FLAG_BITEXACT);
+    if (!s->dsp)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < CELT_MAX_BANDS; i++)
+        s->energy[0][i] = s->energy[1][i] = 0.0f;
+    s->prev_codedbands = CELT_MAX_BANDS;
+
+    ff_af_queue_init(avctx, &s->afq);
+
+    return 0;
+}
+
+static const AVCodecDefault opus_defaults[] = {
+    { "b", "0" },
+    { NULL },
+};
+
+AVCodec ff_opus_encoder = {
+    .name           = "opus",
+    .long_name      = NULL_IF_CONFIG_SMALL("Opus"),
+    .type           = AVMEDIA_TYPE_AUDIO,
+    .id             = AV_CODEC_ID_OPUS,
+    .priv_data_size = sizeof(OpusEncContext),
+    .init           = opus_encode_init,
+    .encode2        = opus_encode_frame,
+    .close          = opus_encode_end,
+    .capabilities   = AV_CODEC_CAP_EXPERIMENTAL | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SMALL_LAST_FRAME,
+    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_INIT_CLEANUP,
+    .defaults       = opus_defaults,
+    .supported_samplerates = (const int []){ 48000, 0 },
+    .channel_layouts = (const uint64_t []){ AV_CH_LAYOUT_MONO,
+                                            AV_CH_LAYOUT_STEREO, 0 },
+    .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_FLTP,
+                                                     AV_SAMPLE_FMT_NONE },
+};
@@ -0,0 +1,65 @@
+/*
+ * Opus CELT tables
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_OPUSTAB_H
+#define AVCODEC_OPUSTAB_H
+
+#include <stdint.h>
+
+#include "libavutil/mem.h"
+
+extern const uint16_t ff_celt_model_tapset[];
+extern const uint16_t ff_celt_model_spread[];
+extern const uint16_t ff_celt_model_alloc_trim[];
+extern const uint16_t ff_celt_model_energy_small[];
+
+extern const uint8_t  ff_celt_freq_bands[];
+extern const uint8_t  ff_celt_freq_range[];
+extern const uint8_t  ff_celt_log_freq_range[];
+
+extern const int8_t   ff_celt_tf_select[4][2][2][2];
+
+extern const float    ff_celt_mean_energy[];
+extern const float    ff_celt_alpha_coef[];
+extern const float    ff_celt_beta_coef[];
+
+extern const uint8_t  ff_celt_coarse_energy_dist[4][2][42];
+
+extern const uint8_t  ff_celt_static_alloc[11][21];
+extern const uint8_t  ff_celt_static_caps[4][2][21];
+
+extern const uint8_t  ff_celt_cache_bits[392];
+extern const int16_t  ff_celt_cache_index[105];
+
+extern const uint8_t  ff_celt_log2_frac[];
+
+extern const uint8_t  ff_celt_bit_interleave[];
+extern const uint8_t  ff_celt_bit_deinterleave[];
+
+extern const uint8_t  ff_celt_hadamard_ordery[];
+
+extern const uint16_t ff_celt_qn_exp2[];
+
+extern const uint32_t ff_celt_pvq_u[1272];
+extern const uint32_t * const ff_celt_pvq_u_row[15];
+
+DECLARE_ALIGNED(32, extern const float, ff_celt_window)[120];
+
+#endif /* AVCODEC_OPUSTAB_H */
@@ -0,0 +1,507 @@
+;******************************************************************************
+;* SIMD-optimized HEVC intra prediction
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+; size - 1 - x is read from offset 32 - size, x + 1 from pw_planar_fwd
+pw_planar_rev: dw 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16
+               dw 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0
+pw_planar_fwd: dw  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16
+               dw 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32
+
+SECTION .text
+
+cextern pw_1
+cextern pw_1024
+
+%if ARCH_X86_64
+
+;------------------------------------------------------------------------------
+; void ff_hevc_pred_planar_NxN_{8,10}_<opt>(uint8_t *src, const uint8_t *top,
+;                                           const uint8_t *left, ptrdiff_t stride)
+;
+; The part of the sum that does not depend on left[y] is kept in m0-m3 and
+; stepped by left[size] - top[x] (m4-m7) on each row, the left[y] weights
+; are in m8-m11. Every term fits in an unsigned word up to 10 bits; the
+; negative step wraps around and cancels out.
+;------------------------------------------------------------------------------
+
+; %1 = size, %2 = log2 size, %3 = bit depth
+%macro PRED_PLANAR 3
+%if %3 == 8
+%assign %%pix 1
+%else
+%assign %%pix 2
+%endif
+%assign %%nvec (%1 + mmsize / 2 - 1) / (mmsize / 2)
+cglobal hevc_pred_planar_%1x%1_%3, 4, 6, 16, src, top, left, stride, y, tmp
+%if %3 != 8
+    add          strideq, strideq               ; stride is in pixels
+%endif
+%if %3 == 8
+    movzx           tmpd, byte [topq + %1]
+    movd            xm12, tmpd
+    movzx           tmpd, byte [leftq + %1]
+%else
+    movzx           tmpd, word [topq + 2 * %1]
+    movd            xm12, tmpd
+    movzx           tmpd, word [leftq + 2 * %1]
+%endif
+    movd            xm13, tmpd
+    add             tmpd, %1
+    movd            xm14, tmpd
+    SPLATW           m12, xm12                  ; top[size]
+    SPLATW           m13, xm13                  ; left[size]
+    SPLATW           m14, xm14                  ; left[size] + size
+
+%assign %%i 0
+%rep %%nvec
+%assign %%d %%i + 4
+%assign %%w %%i + 8
+%if %3 == 8
+    pmovzxbw         m15, [topq + %%i * mmsize / 2]
+%else
+    movu             m15, [topq + %%i * mmsize]
+%endif
+    pmullw      m %+ %%i, m12, [pw_planar_fwd + %%i * mmsize]
+    paddw       m %+ %%i, m14
+    psubw       m %+ %%d, m13, m15
+    psubw       m %+ %%i, m15
+    psllw            m15, %2
+    paddw       m %+ %%i, m15                   ; row 0 without the left[y] term
+    movu        m %+ %%w, [pw_planar_rev + 2 * (32 - %1) + %%i * mmsize]
+%assign %%i %%i + 1
+%endrep
+
+    mov               yd, %1
+.loop:
+%if %3 == 8
+    movzx           tmpd, byte [leftq]
+%else
+    movzx           tmpd, word [leftq]
+%endif
+    movd            xm15, tmpd
+    SPLATW           m15, xm15
+
+%assign %%i 0
+%rep %%nvec
+%assign %%d %%i + 4
+%assign %%w %%i + 8
+%assign %%t 12 + (%%i & 1)
+    pmullw      m %+ %%t, m %+ %%w, m15
+    paddw       m %+ %%t, m %+ %%i
+    psrlw       m %+ %%t, %2 + 1
+    paddw       m %+ %%i, m %+ %%d
+%if %3 == 8
+%if %%nvec == 1
+    packuswb         m12, m12
+%if mmsize == 32
+    vpermq           m12, m12, q2020
+    movu           [srcq], xm12
+%elif %1 == 4
+    movd           [srcq], m12
+%else
+    movq           [srcq], m12
+%endif
+%elif %%i & 1
+    packuswb         m12, m13
+%if mmsize == 32
+    vpermq           m12, m12, q3120
+%endif
+    movu [srcq + (%%i / 2) * mmsize], m12
+%endif
+%else ; %3 == 10
+%if %1 == 4
+    movq           [srcq], m12
+%else
+    movu [srcq + %%i * mmsize], m %+ %%t
+%endif
+%endif
+%assign %%i %%i + 1
+%endrep
+
+    add             srcq, strideq
+    add            leftq, %%pix
+    dec               yd
+    jg .loop
+    RET
+%endmacro
+
+INIT_XMM sse4
+PRED_PLANAR  4, 2, 8
+PRED_PLANAR  8, 3, 8
+PRED_PLANAR 16, 4, 8
+PRED_PLANAR 32, 5, 8
+
+INIT_XMM sse2
+PRED_PLANAR  4, 2, 10
+PRED_PLANAR  8, 3, 10
+PRED_PLANAR 16, 4, 10
+PRED_PLANAR 32, 5, 10
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+PRED_PLANAR 16, 4, 8
+PRED_PLANAR 32, 5, 8
+PRED_PLANAR 16, 4, 10
+PRED_PLANAR 32, 5, 10
+%endif
+
+;------------------------------------------------------------------------------
+; void ff_hevc_pred_dc_NxN_{8,10}_<opt>(uint8_t *src, const uint8_t *top,
+;                                       const uint8_t *left, ptrdiff_t stride,
+;                                       int c_idx)
+;------------------------------------------------------------------------------
+
+; %1 = size, %2 = bit depth, source register
+%macro DC_STORE_ROW 3
+%if %2 == 8
+%if %1 == 4
+    movd             [%3], m1
+%elif %1 == 8
+    movq             [%3], m1
+%else
+    movu             [%3], m1
+%if %1 == 32
+    movu        [%3 + 16], m1
+%endif
+%endif
+%else
+%if %1 == 4
+    movq             [%3], m1
+%else
+%assign %%j 0
+%rep %1 / 8
+    movu  [%3 + %%j * 16], m1
+%assign %%j %%j + 1
+%endrep
+%endif
+%endif
+%endmacro
+
+; %1 = size, %2 = log2 size, %3 = bit depth
+%macro PRED_DC 3
+cglobal hevc_pred_dc_%1x%1_%3, 5, 8, 5, src, top, left, stride, c_idx, dc, y, tmp
+%if %3 != 8
+    add          strideq, strideq               ; stride is in pixels
+%endif
+    pxor              m0, m0
+%if %3 == 8
+%if %1 == 4
+    movd              m1, [topq]
+    movd              m2, [leftq]
+    punpckldq         m1, m2
+    psadbw            m1, m0
+%elif %1 == 8
+    movq              m1, [topq]
+    movhps            m1, [leftq]
+    psadbw            m1, m0
+    movhlps           m2, m1
+    paddw             m1, m2
+%else
+    movu              m1, [topq]
+    movu              m2, [leftq]
+    psadbw            m1, m0
+    psadbw            m2, m0
+    paddw             m1, m2
+%if %1 == 32
+    movu              m2, [topq + 16]
+    movu              m3, [leftq + 16]
+    psadbw            m2, m0
+    psadbw            m3, m0
+    paddw             m1, m2
+    paddw             m1, m3
+%endif
+    movhlps           m2, m1
+    paddw             m1, m2
+%endif
+    movd             dcd, m1
+%else ; %3 == 10
+%if %1 == 4
+    movq              m1, [topq]
+    movhps            m1, [leftq]
+%else
+    movu              m1, [topq]
+    movu              m2, [leftq]
+    paddw             m1, m2
+%assign %%j 1
+%rep %1 / 8 - 1
+    movu              m2, [topq + %%j * 16]
+    movu              m3, [leftq + %%j * 16]
+    paddw             m1, m2
+    paddw             m1, m3
+%assign %%j %%j + 1
+%endrep
+%endif
+    pmaddwd           m1, [pw_1]
+    HADDD             m1, m2
+    movd             dcd, m1
+%endif
+    add              dcd, %1
+    shr              dcd, %2 + 1
+
+    movd              m1, dcd
+%if %3 == 8
+    pshufb            m1, m0
+%else
+    SPLATW            m1, m1
+%endif
+    mov             tmpq, srcq
+    mov               yd, %1
+.loop:
+    DC_STORE_ROW      %1, %3, tmpq
+    add             tmpq, strideq
+    dec               yd
+    jg .loop
+
+%if %1 < 32
+    test          c_idxd, c_idxd
+    jnz .end
+
+    ; first row: (top[x] + 3 * dc + 2) >> 2
+    lea             tmpd, [dcq * 3 + 2]
+    movd              m2, tmpd
+    SPLATW            m2, m2
+%if %3 == 8
+    pmovzxbw          m3, [topq]
+    paddw             m3, m2
+    psrlw             m3, 2
+%if %1 == 16
+    pmovzxbw          m4, [topq + 8]
+    paddw             m4, m2
+    psrlw             m4, 2
+    packuswb          m3, m4
+    movu           [srcq], m3
+%else
+    packuswb          m3, m3
+%if %1 == 4
+    movd           [srcq], m3
+%else
+    movq           [srcq], m3
+%endif
+%endif
+%else ; %3 == 10
+%if %1 == 4
+    movq              m3, [topq]
+    paddw             m3, m2
+    psrlw             m3, 2
+    movq           [srcq], m3
+%else
+%assign %%j 0
+%rep %1 / 8
+    movu              m3, [topq + %%j * 16]
+    paddw             m3, m2
+    psrlw             m3, 2
+    movu [srcq + %%j * 16], m3
+%assign %%j %%j + 1
+%endrep
+%endif
+%endif
+
+    ; top-left: (left[0] + 2 * dc + top[0] + 2) >> 2
+%if %3 == 8
+    movzx             yd, byte [topq]
+    movzx           tmpd, byte [leftq]
+%else
+    movzx             yd, word [topq]
+    movzx           tmpd, word [leftq]
+%endif
+    add               yd, tmpd
+    lea               yd, [yq + dcq * 2 + 2]
+    shr               yd, 2
+%if %3 == 8
+    mov            [srcq], yb
+%else
+    mov            [srcq], yw
+%endif
+
+    ; first column: (left[y] + 3 * dc + 2) >> 2
+    lea              dcd, [dcq * 3 + 2]
+    mov               yd, 1
+.loop_col:
+    add             srcq, strideq
+%if %3 == 8
+    movzx           tmpd, byte [leftq + yq]
+%else
+    movzx           tmpd, word [leftq + yq * 2]
+%endif
+    add             tmpd, dcd
+    shr             tmpd, 2
+%if %3 == 8
+    mov            [srcq], tmpb
+%else
+    mov            [srcq], tmpw
+%endif
+    inc               yd
+    cmp               yd, %1
+    jl .loop_col
+.end:
+%endif
+    RET
+%endmacro
+
+INIT_XMM sse4
+PRED_DC  4, 2, 8
+PRED_DC  8, 3, 8
+PRED_DC 16, 4, 8
+PRED_DC 32, 5, 8
+
+INIT_XMM sse2
+PRED_DC  4, 2, 10
+PRED_DC  8, 3, 10
+PRED_DC 16, 4, 10
+PRED_DC 32, 5, 10
+
+;------------------------------------------------------------------------------
+; void ff_hevc_pred_angular_{v,h}_NxN_8_<opt>(uint8_t *src, const uint8_t *ref,
+;                                             ptrdiff_t stride, int angle)
+;
+; ref is the main reference as built by the C code (ref[0] is the top-left
+; sample, negative indices hold the projected side reference) and must be
+; readable for 2 * size + 32 bytes. Each output sample is
+; ((32 - fact) * ref[i + idx + 1] + fact * ref[i + idx + 2] + 16) >> 5,
+; computed with pmaddubsw on (32 - fact, fact) byte pairs and rounded by
+; pmulhrsw with 1024. The v variant walks rows, the h variant computes
+; columns of 8x8 tiles and transposes them.
+;------------------------------------------------------------------------------
+
+; %1 = weight register, %2 = position register
+%macro ANGULAR_WEIGHTS 2
+    mov             tmpd, %2
+    and             tmpd, 31
+    imul            tmpd, tmpd, 255
+    add             tmpd, 32                    ; fact << 8 | (32 - fact)
+    movd              %1, tmpd
+    SPLATW            %1, %1
+%endmacro
+
+; %1 = size
+%macro PRED_ANGULAR_V 1
+cglobal hevc_pred_angular_v_%1x%1_8, 4, 8, 8, src, ref, stride, angle, y, pos, idx, tmp
+    mova              m7, [pw_1024]
+    mov             posd, angled
+    mov               yd, %1
+.loop:
+    mov             idxd, posd
+    sar             idxd, 5
+    movsxd          idxq, idxd
+    ANGULAR_WEIGHTS   m6, posd
+%assign %%j 0
+%rep (%1 + 15) / 16
+    movu              m0, [refq + idxq + %%j * 16 + 1]
+    movu              m1, [refq + idxq + %%j * 16 + 2]
+    punpckhbw         m2, m0, m1
+    punpcklbw         m0, m1
+    pmaddubsw         m0, m6
+    pmaddubsw         m2, m6
+    pmulhrsw          m0, m7
+    pmulhrsw          m2, m7
+    packuswb          m0, m2
+%if %1 == 4
+    movd           [srcq], m0
+%elif %1 == 8
+    movq           [srcq], m0
+%else
+    movu [srcq + %%j * 16], m0
+%endif
+%assign %%j %%j + 1
+%endrep
+    add             posd, angled
+    add             srcq, strideq
+    dec               yd
+    jg .loop
+    RET
+%endmacro
+
+; %1 = size
+%macro PRED_ANGULAR_H 1
+cglobal hevc_pred_angular_h_%1x%1_8, 4, 11, 11, src, ref, stride, angle, tx, ty, pos, xpos, idx, tmp, dst
+    mova             m10, [pw_1024]
+    movsxd        angleq, angled
+    mov            xposd, angled
+    mov              txd, (%1 + 7) / 8
+.loop_x:
+    xor              tyd, tyd
+    mov             dstq, srcq
+.loop_y:
+    mov             posd, xposd
+%assign %%c 0
+%rep 8
+    mov             idxd, posd
+    sar             idxd, 5
+    movsxd          idxq, idxd
+    add             idxq, tyq
+    ANGULAR_WEIGHTS   m9, posd
+    movq        m %+ %%c, [refq + idxq + 1]
+    movq              m8, [refq + idxq + 2]
+    punpcklbw   m %+ %%c, m8
+    pmaddubsw   m %+ %%c, m9
+    pmulhrsw    m %+ %%c, m10
+    add             posd, angled
+%assign %%c %%c + 1
+%endrep
+    TRANSPOSE8x8W      0, 1, 2, 3, 4, 5, 6, 7, 8
+    packuswb          m0, m1
+    packuswb          m2, m3
+%if %1 == 4
+    movd           [dstq], m0
+    pextrd [dstq + strideq], m0, 2
+    lea             dstq, [dstq + strideq * 2]
+    movd           [dstq], m2
+    pextrd [dstq + strideq], m2, 2
+%else
+    packuswb          m4, m5
+    packuswb          m6, m7
+    movq           [dstq], m0
+    movhps [dstq + strideq], m0
+    lea             dstq, [dstq + strideq * 2]
+    movq           [dstq], m2
+    movhps [dstq + strideq], m2
+    lea             dstq, [dstq + strideq * 2]
+    movq           [dstq], m4
+    movhps [dstq + strideq], m4
+    lea             dstq, [dstq + strideq * 2]
+    movq           [dstq], m6
+    movhps [dstq + strideq], m6
+    lea             dstq, [dstq + strideq * 2]
+    add              tyd, 8
+    cmp              tyd, %1
+    jl .loop_y
+%endif
+    add             srcq, 8
+    lea            xposd, [xposq + angleq * 8]
+    dec              txd
+    jg .loop_x
+    RET
+%endmacro
+
+INIT_XMM sse4
+PRED_ANGULAR_V  4
+PRED_ANGULAR_V  8
+PRED_ANGULAR_V 16
+PRED_ANGULAR_V 32
+PRED_ANGULAR_H  4
+PRED_ANGULAR_H  8
+PRED_ANGULAR_H 16
+PRED_ANGULAR_H 32
+
+%endif ; ARCH_X86_64
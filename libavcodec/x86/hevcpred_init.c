@@ -0,0 +1,191 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/internal.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/hevcpred.h"
+
+#define PRED_PLANAR_FUNC(size, depth, opt)                                              \
+void ff_hevc_pred_planar_ ## size ## x ## size ## _ ## depth ## _ ## opt(uint8_t *src,  \
+                                                                       const uint8_t *top,  \
+                                                                       const uint8_t *left, \
+                                                                       ptrdiff_t stride);
+
+#define PRED_DC_FUNC(size, depth, opt)                                                  \
+void ff_hevc_pred_dc_ ## size ## x ## size ## _ ## depth ## _ ## opt(uint8_t *src,      \
+                                                                   const uint8_t *top,  \
+                                                                   const uint8_t *left, \
+                                                                   ptrdiff_t stride,    \
+                                                                   int c_idx);
+
+#define PRED_ANGULAR_FUNCS(size, opt)                                                   \
+void ff_hevc_pred_angular_v_ ## size ## x ## size ## _8_ ## opt(uint8_t *src,           \
+                                                              const uint8_t *ref,     \
+                                                              ptrdiff_t stride,       \
+                                                              int angle);             \
+void ff_hevc_pred_angular_h_ ## size ## x ## size ## _8_ ## opt(uint8_t *src,           \
+                                                              const uint8_t *ref,     \
+                                                              ptrdiff_t stride,       \
+                                                              int angle);
+
+#define PRED_FUNCS(macro, depth, opt) \
+    macro( 4, depth, opt)             \
+    macro( 8, depth, opt)             \
+    macro(16, depth, opt)             \
+    macro(32, depth, opt)
+
+PRED_FUNCS(PRED_PLANAR_FUNC, 8,  sse4)
+PRED_FUNCS(PRED_PLANAR_FUNC, 10, sse2)
+PRED_PLANAR_FUNC(16, 8,  avx2)
+PRED_PLANAR_FUNC(32, 8,  avx2)
+PRED_PLANAR_FUNC(16, 10, avx2)
+PRED_PLANAR_FUNC(32, 10, avx2)
+
+PRED_FUNCS(PRED_DC_FUNC, 8,  sse4)
+PRED_FUNCS(PRED_DC_FUNC, 10, sse2)
+
+PRED_ANGULAR_FUNCS( 4, sse4)
+PRED_ANGULAR_FUNCS( 8, sse4)
+PRED_ANGULAR_FUNCS(16, sse4)
+PRED_ANGULAR_FUNCS(32, sse4)
+
+#if ARCH_X86_64 && HAVE_YASM
+#define PRED_DC(depth, opt)                                                             \
+static void hevc_pred_dc_ ## depth ## _ ## opt(uint8_t *src, const uint8_t *top,        \
+                                               const uint8_t *left, ptrdiff_t stride,  \
+                                               int log2_size, int c_idx)               \
+{                                                                                       \
+    switch (log2_size) {                                                                \
+    case 2: ff_hevc_pred_dc_4x4_   ## depth ## _ ## opt(src, top, left, stride, c_idx); break; \
+    case 3: ff_hevc_pred_dc_8x8_   ## depth ## _ ## opt(src, top, left, stride, c_idx); break; \
+    case 4: ff_hevc_pred_dc_16x16_ ## depth ## _ ## opt(src, top, left, stride, c_idx); break; \
+    case 5: ff_hevc_pred_dc_32x32_ ## depth ## _ ## opt(src, top, left, stride, c_idx); break; \
+    }                                                                                   \
+}
+
+PRED_DC(8,  sse4)
+PRED_DC(10, sse2)
+
+static const int8_t intra_pred_angle[] = {
+     32,  26,  21,  17, 13,  9,  5, 2, 0, -2, -5, -9, -13, -17, -21, -26, -32,
+    -26, -21, -17, -13, -9, -5, -2, 0, 2,  5,  9, 13,  17,  21,  26,  32
+};
+
+static const int16_t inv_angle[] = {
+    -4096, -1638, -910, -630, -482, -390, -315, -256, -315, -390, -482,
+    -630, -910, -1638, -4096
+};
+
+typedef void (*pred_angular_func)(uint8_t *src, const uint8_t *ref,
+                                  ptrdiff_t stride, int angle);
+
+/* Builds the main reference the same way as the C version, then leaves the
+ * interpolation to the asm. The copy also gives the asm room to read whole
+ * vectors past 2 * size + 1 samples, which the edge arrays do not have. */
+static av_always_inline void pred_angular_8(uint8_t *src, const uint8_t *top,
+                                            const uint8_t *left, ptrdiff_t stride,
+                                            int c_idx, int mode, int size,
+                                            pred_angular_func vert,
+                                            pred_angular_func hor)
+{
+    LOCAL_ALIGNED_16(uint8_t, ref_array, [3 * 32 + 48]);
+    uint8_t *ref = ref_array + 32;
+    int angle    = intra_pred_angle[mode - 2];
+    int last     = (size * angle) >> 5;
+    const uint8_t *main_ref = mode >= 18 ? top  : left;
+    const uint8_t *side_ref = mode >= 18 ? left : top;
+    int i;
+
+    memcpy(ref, main_ref - 1, 2 * size + 1);
+    if (angle < 0 && last < -1)
+        for (i = last; i <= -1; i++)
+            ref[i] = side_ref[-1 + ((i * inv_angle[mode - 11] + 128) >> 8)];
+
+    if (mode >= 18) {
+        vert(src, ref, stride, angle);
+        if (mode == 26 && c_idx == 0 && size < 32)
+            for (i = 0; i < size; i++)
+                src[i * stride] = av_clip_uint8(top[0] + ((left[i] - left[-1]) >> 1));
+    } else {
+        hor(src, ref, stride, angle);
+        if (mode == 10 && c_idx == 0 && size < 32)
+            for (i = 0; i < size; i++)
+                src[i] = av_clip_uint8(left[0] + ((top[i] - top[-1]) >> 1));
+    }
+}
+
+#define PRED_ANGULAR(size, opt)                                                         \
+static void hevc_pred_angular_ ## size ## x ## size ## _8_ ## opt(uint8_t *src,         \
+                                                                const uint8_t *top,   \
+                                                                const uint8_t *left,  \
+                                                                ptrdiff_t stride,     \
+                                                                int c_idx, int mode)  \
+{                                                                                       \
+    pred_angular_8(src, top, left, stride, c_idx, mode, size,                           \
+                   ff_hevc_pred_angular_v_ ## size ## x ## size ## _8_ ## opt,          \
+                   ff_hevc_pred_angular_h_ ## size ## x ## size ## _8_ ## opt);         \
+}
+
+PRED_ANGULAR( 4, sse4)
+PRED_ANGULAR( 8, sse4)
+PRED_ANGULAR(16, sse4)
+PRED_ANGULAR(32, sse4)
+#endif /* ARCH_X86_64 && HAVE_YASM */
+
+av_cold void ff_hevc_pred_init_x86(HEVCPredContext *hpc, int bit_depth)
+{
+#if ARCH_X86_64 && HAVE_YASM
+    int cpu_flags = av_get_cpu_flags();
+
+    if (bit_depth == 8) {
+        if (EXTERNAL_SSE4(cpu_flags)) {
+            hpc->pred_planar[0]  = ff_hevc_pred_planar_4x4_8_sse4;
+            hpc->pred_planar[1]  = ff_hevc_pred_planar_8x8_8_sse4;
+            hpc->pred_planar[2]  = ff_hevc_pred_planar_16x16_8_sse4;
+            hpc->pred_planar[3]  = ff_hevc_pred_planar_32x32_8_sse4;
+            hpc->pred_dc         = hevc_pred_dc_8_sse4;
+            hpc->pred_angular[0] = hevc_pred_angular_4x4_8_sse4;
+            hpc->pred_angular[1] = hevc_pred_angular_8x8_8_sse4;
+            hpc->pred_angular[2] = hevc_pred_angular_16x16_8_sse4;
+            hpc->pred_angular[3] = hevc_pred_angular_32x32_8_sse4;
+        }
+        if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+            hpc->pred_planar[2]  = ff_hevc_pred_planar_16x16_8_avx2;
+            hpc->pred_planar[3]  = ff_hevc_pred_planar_32x32_8_avx2;
+        }
+    } else if (bit_depth == 10) {
+        if (EXTERNAL_SSE2(cpu_flags)) {
+            hpc->pred_planar[0]  = ff_hevc_pred_planar_4x4_10_sse2;
+            hpc->pred_planar[1]  = ff_hevc_pred_planar_8x8_10_sse2;
+            hpc->pred_planar[2]  = ff_hevc_pred_planar_16x16_10_sse2;
+            hpc->pred_planar[3]  = ff_hevc_pred_planar_32x32_10_sse2;
+            hpc->pred_dc         = hevc_pred_dc_10_sse2;
+        }
+        if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+            hpc->pred_planar[2]  = ff_hevc_pred_planar_16x16_10_avx2;
+            hpc->pred_planar[3]  = ff_hevc_pred_planar_32x32_10_avx2;
+        }
+    }
+#endif /* ARCH_X86_64 && HAVE_YASM */
+}
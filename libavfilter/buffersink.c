@@ -31,6 +31,9 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 
+#define FF_INTERNAL_FIELDS 1
+#include "framequeue.h"
+
 #include "audio.h"
 #include "avfilter.h"
 #include "buffersink.h"
@@ -134,17 +137,15 @@ int attribute_align_arg av_buffersink_get_frame_flags(AVFilterContext *ctx, AVFr
 
     /* no picref available, fetch it from the filterchain */
     while (!av_fifo_size(buf->fifo)) {
-        if (inlink->status)
-            return inlink->status;
+        if (inlink->status_out)
+            return inlink->status_out;
         if (flags & AV_BUFFERSINK_FLAG_NO_REQUEST)
             return AVERROR(EAGAIN);
-        if ((ret = ff_request_frame(inlink)) < 0)
+        if (!inlink->frame_wanted_out && (ret = ff_request_frame(inlink)) < 0)
+            return ret;
+        ret = ff_filter_graph_run_once(ctx->graph);
+        if (ret < 0)
             return ret;
-        while (inlink->frame_wanted_out) {
-            ret = ff_filter_graph_run_once(ctx->graph);
-            if (ret < 0)
-                return ret;
-        }
     }
 
     if (flags & AV_BUFFERSINK_FLAG_PEEK) {
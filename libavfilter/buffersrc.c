@@ -33,6 +33,10 @@
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "libavutil/samplefmt.h"
+
+#define FF_INTERNAL_FIELDS 1
+#include "framequeue.h"
+
 #include "audio.h"
 #include "avfilter.h"
 #include "buffersrc.h"
@@ -173,6 +177,30 @@ int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFra
     return ret;
 }
 
+static int push_frame(AVFilterGraph *graph)
+{
+    int ret;
+
+    while (1) {
+        ret = ff_filter_graph_run_once(graph);
+        if (ret == AVERROR(EAGAIN))
+            break;
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+/* New input: the next request on the output may succeed */
+static void source_unblock(AVFilterContext *ctx)
+{
+    AVFilterLink *outlink = ctx->outputs[0];
+
+    outlink->frame_blocked_in = 0;
+    if (outlink->frame_wanted_out)
+        ff_filter_set_ready(ctx, 100);
+}
+
 static int av_buffersrc_add_frame_internal(AVFilterContext *ctx,
                                            AVFrame *frame, int flags)
 {
@@ -184,6 +212,7 @@ static int av_buffersrc_add_frame_internal(AVFilterContext *ctx,
 
     if (!frame) {
         s->eof = 1;
+        source_unblock(ctx);
         return 0;
     } else if (s->eof)
         return AVERROR(EINVAL);
@@ -235,9 +264,14 @@ static int av_buffersrc_add_frame_internal(AVFilterContext *ctx,
         return ret;
     }
 
-    if ((flags & AV_BUFFERSRC_FLAG_PUSH))
+    source_unblock(ctx);
+
+    if ((flags & AV_BUFFERSRC_FLAG_PUSH)) {
         if ((ret = ctx->output_pads[0].request_frame(ctx->outputs[0])) < 0)
             return ret;
+        if ((ret = push_frame(ctx->graph)) < 0)
+            return ret;
+    }
 
     return 0;
 }
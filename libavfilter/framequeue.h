@@ -0,0 +1,138 @@
+/*
+ * Generic frame queue
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_FRAMEQUEUE_H
+#define AVFILTER_FRAMEQUEUE_H
+
+/**
+ * FIFO queue of frames, used to buffer the frames sent through a link
+ * until the destination filter is activated to process them.
+ *
+ * The queue is implemented as a ring buffer that grows as needed; a queue
+ * holding at most one frame never allocates memory.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/frame.h"
+
+typedef struct FFFrameBucket {
+    AVFrame *frame;
+} FFFrameBucket;
+
+/**
+ * Queue of AVFrame pointers.
+ */
+typedef struct FFFrameQueue {
+
+    /**
+     * Array of allocated buckets, used as a circular buffer.
+     */
+    FFFrameBucket *queue;
+
+    /**
+     * Size of the array of buckets.
+     */
+    size_t allocated;
+
+    /**
+     * Tail of the queue.
+     * It is the index in the array of the next frame to take.
+     */
+    size_t tail;
+
+    /**
+     * Number of currently queued frames.
+     */
+    size_t queued;
+
+    /**
+     * Pre-allocated bucket for queues of size 1.
+     */
+    FFFrameBucket first_bucket;
+
+    /**
+     * Total number of frames entered in the queue.
+     */
+    uint64_t total_frames_head;
+
+    /**
+     * Total number of frames dequeued from the queue.
+     */
+    uint64_t total_frames_tail;
+
+    /**
+     * Total number of samples entered in the queue.
+     */
+    uint64_t total_samples_head;
+
+    /**
+     * Total number of samples dequeued from the queue.
+     */
+    uint64_t total_samples_tail;
+
+} FFFrameQueue;
+
+/**
+ * Init a frame queue.
+ */
+void ff_framequeue_init(FFFrameQueue *fq);
+
+/**
+ * Free the queue and all queued frames.
+ */
+void ff_framequeue_free(FFFrameQueue *fq);
+
+/**
+ * Add a frame.
+ * @return  >=0 or an AVERROR code; the frame is freed on failure.
+ */
+int ff_framequeue_add(FFFrameQueue *fq, AVFrame *frame);
+
+/**
+ * Take the first frame in the queue.
+ * Must not be used with empty queues.
+ */
+AVFrame *ff_framequeue_take(FFFrameQueue *fq);
+
+/**
+ * Access a frame in the queue, without removing it.
+ * The first frame is numbered 0; the designated frame must exist.
+ */
+AVFrame *ff_framequeue_peek(FFFrameQueue *fq, size_t idx);
+
+/**
+ * Get the number of queued frames.
+ */
+static inline size_t ff_framequeue_queued_frames(const FFFrameQueue *fq)
+{
+    return fq->queued;
+}
+
+/**
+ * Get the number of queued samples.
+ */
+static inline uint64_t ff_framequeue_queued_samples(const FFFrameQueue *fq)
+{
+    return fq->total_samples_head - fq->total_samples_tail;
+}
+
+#endif /* AVFILTER_FRAMEQUEUE_H */
@@ -336,6 +336,29 @@ int ff_request_frame(AVFilterLink *link);
 
 int ff_request_frame_to_filter(AVFilterLink *link);
 
+/**
+ * Special return code when activate() did not do anything.
+ */
+#define FFERROR_NOT_READY FFERRTAG('N','R','D','Y')
+
+/**
+ * Mark a filter ready and schedule it for activation.
+ *
+ * This is automatically done when something happens to the filter (queued
+ * frame, status change, request on output).
+ * Filters implementing the activate callback can call it directly to
+ * perform one more round of processing later.
+ * It is also useful for filters reacting to external or asynchronous
+ * events.
+ */
+void ff_filter_set_ready(AVFilterContext *filter, unsigned priority);
+
+/**
+ * Perform one step of processing on a filter, using its activate
+ * callback or the default implementation for legacy filters.
+ */
+int ff_filter_activate(AVFilterContext *filter);
+
 #define AVFILTER_DEFINE_CLASS(fname)            \
     static const AVClass fname##_class = {      \
         .class_name = #fname,                   \
@@ -382,7 +405,10 @@ AVFilterContext *ff_filter_alloc(const AVFilter *filter, const char *inst_name);
 void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter);
 
 /**
- * Run one round of processing on a filter graph.
+ * Run one round of processing on a filter graph: activate the filter with
+ * the highest ready priority.
+ *
+ * @return  >= 0 on success, AVERROR(EAGAIN) if no filter is ready
  */
 int ff_filter_graph_run_once(AVFilterGraph *graph);
 
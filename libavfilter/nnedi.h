@@ -0,0 +1,42 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AVFILTER_NNEDI_H
+#define AVFILTER_NNEDI_H
+
+typedef struct NNEDIDSPContext {
+    /**
+     * Evaluate n neurons on the len inputs at data. The weights of neuron i
+     * are at weights + i * len, followed by the n biases:
+     * vals[i] = dot(data, weights + i * len) * scale + weights[n * len + i].
+     * n and len are multiples of 4.
+     */
+    void (*dot_prod)(const float *data, const float *weights, float *vals,
+                     int n, int len, float scale);
+
+    /**
+     * s[i] = exp(s[i]) with the argument clipped to [-80, 80].
+     * n is a multiple of 16.
+     */
+    void (*expfunc)(float *s, int n);
+} NNEDIDSPContext;
+
+void ff_nnedi_init(NNEDIDSPContext *dsp);
+void ff_nnedi_init_x86(NNEDIDSPContext *dsp);
+
+#endif /* AVFILTER_NNEDI_H */
@@ -0,0 +1,47 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_OVERLAY_H
+#define AVFILTER_OVERLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct OverlayDSPContext {
+    /**
+     * Blend w pixels of src onto dst weighted by the overlay alpha:
+     * dst = (dst * (255 - alpha) + src * alpha) / 255, rounded.
+     * w is a positive multiple of 16.
+     */
+    void (*blend_row)(uint8_t *dst, const uint8_t *src, const uint8_t *alpha,
+                      int w);
+
+    /**
+     * Same as blend_row() for a plane subsampled 2x2 against the alpha
+     * plane. The alpha of each pixel is the average of the 2x2 block at
+     * alpha and alpha + alpha_linesize.
+     */
+    void (*blend_row_420)(uint8_t *dst, const uint8_t *src,
+                          const uint8_t *alpha, ptrdiff_t alpha_linesize,
+                          int w);
+} OverlayDSPContext;
+
+void ff_overlay_init(OverlayDSPContext *dsp);
+void ff_overlay_init_x86(OverlayDSPContext *dsp);
+
+#endif /* AVFILTER_OVERLAY_H */
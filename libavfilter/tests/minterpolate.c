@@ -0,0 +1,151 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/time.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+#define MAX_FRAMES 64
+
+typedef struct Result {
+    int nb_frames;
+    unsigned long crcs[MAX_FRAMES];
+    int64_t time;
+} Result;
+
+/* Interpolate the output of testsrc2 with minterpolate and checksum the
+ * frames, using nb_threads threads for the filters. */
+static int run(const char *size, int rate, double duration, int out_rate,
+               const char *options, int nb_threads, Result *res)
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext *sink;
+    AVFilterInOut *inputs = NULL, *outputs = NULL;
+    AVFrame *frame = av_frame_alloc();
+    char desc[512];
+    int ret, plane, y;
+
+    memset(res, 0, sizeof(*res));
+    if (!graph || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = nb_threads;
+
+    snprintf(desc, sizeof(desc),
+             "testsrc2=s=%s:r=%d:d=%g,format=yuv420p,minterpolate=fps=%d%s%s",
+             size, rate, duration, out_rate, *options ? ":" : "", options);
+    if ((ret = avfilter_graph_create_filter(&sink, avfilter_get_by_name("buffersink"),
+                                            "out", NULL, NULL, graph)) < 0 ||
+        (ret = avfilter_graph_parse2(graph, desc, &inputs, &outputs)) < 0)
+        goto end;
+    if (inputs || !outputs || outputs->next) {
+        ret = AVERROR(EINVAL);
+        goto end;
+    }
+    if ((ret = avfilter_link(outputs->filter_ctx, outputs->pad_idx, sink, 0)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+
+    res->time = av_gettime_relative();
+    while ((ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+        if (res->nb_frames < MAX_FRAMES) {
+            unsigned long crc = 0;
+
+            for (plane = 0; plane < 3; plane++) {
+                int w = plane ? AV_CEIL_RSHIFT(frame->width,  1) : frame->width;
+                int h = plane ? AV_CEIL_RSHIFT(frame->height, 1) : frame->height;
+
+                for (y = 0; y < h; y++)
+                    crc = av_adler32_update(crc, frame->data[plane] + y * frame->linesize[plane], w);
+            }
+            res->crcs[res->nb_frames] = crc;
+        }
+        res->nb_frames++;
+        av_frame_unref(frame);
+    }
+    res->time = av_gettime_relative() - res->time;
+    if (ret == AVERROR_EOF)
+        ret = 0;
+
+end:
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+static int bench(int nb_threads)
+{
+    static const char *const sizes[] = { "1280x720", "1920x1080" };
+    Result res;
+    int i, ret;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        if ((ret = run(sizes[i], 25, 2, 50, "", nb_threads, &res)) < 0) {
+            fprintf(stderr, "%s: %s\n", sizes[i], av_err2str(ret));
+            return 1;
+        }
+        printf("%-9s 25 -> 50 fps: %6.2f fps\n", sizes[i],
+               res.nb_frames * 1000000.0 / res.time);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const options[] = {
+        "me_mode=bidir",
+        "me_mode=bilat",
+        "me_mode=bilat:mc_mode=aobmc:vsbmc=1",
+        "me_mode=bidir:me=umh:mb_size=8",
+        "me_mode=bilat:me=hexbs:mb_size=4",
+    };
+    Result ref, res;
+    int i, j, ret;
+
+    avfilter_register_all();
+
+    if (argc > 1 && !strcmp(argv[1], "-t"))
+        return bench(argc > 2 ? atoi(argv[2]) : 0);
+
+    /* the threads split the frames differently, the output must not change */
+    for (i = 0; i < FF_ARRAY_ELEMS(options); i++) {
+        if ((ret = run("171x99", 10, 0.5, 25, options[i], 1, &ref)) < 0 ||
+            (ret = run("171x99", 10, 0.5, 25, options[i], 3, &res)) < 0) {
+            fprintf(stderr, "%s: %s\n", options[i], av_err2str(ret));
+            return 1;
+        }
+        printf("%s:", options[i]);
+        for (j = 0; j < FFMIN(ref.nb_frames, MAX_FRAMES); j++)
+            printf("%s0x%08lx", j % 4 ? " " : "\n    ", ref.crcs[j]);
+        printf("\n");
+        if (res.nb_frames != ref.nb_frames ||
+            memcmp(res.crcs, ref.crcs, sizeof(ref.crcs))) {
+            fprintf(stderr, "%s: output differs with 3 threads\n", options[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
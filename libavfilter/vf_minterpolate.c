@@ -157,6 +157,14 @@ typedef struct Frame {
     Block *blocks;
 } Frame;
 
+typedef struct ThreadData {
+    Block *blocks;
+    int dir;
+    int wave;               ///< searched wavefront, or -1 to search all blocks
+    int alpha;
+    AVFrame *avf_out;
+} ThreadData;
+
 typedef struct MIContext {
     const AVClass *class;
     AVMotionEstContext me_ctx;
@@ -256,8 +264,8 @@ static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int
     int linesize = me_ctx->linesize;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, me_ctx->x_min, me_ctx->x_max);
     y = av_clip(y, me_ctx->y_min, me_ctx->y_max);
@@ -267,9 +275,7 @@ static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int
     data_cur += (y + mv_y) * linesize;
     data_next += (y - mv_y) * linesize;
 
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + j * linesize] - data_next[x - mv_x + i + j * linesize]);
+    sbad = ff_me_block_sad(me_ctx, data_cur + x + mv_x, data_next + x - mv_x, me_ctx->mb_size);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -285,17 +291,18 @@ static uint64_t get_sbad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv,
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - x_min, x_max - x), FFMIN(x - x_min, x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - y_min, y_max - y), FFMIN(y - y_min, y_max - y));
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + (y + mv_y + j) * linesize] - data_next[x - mv_x + i + (y - mv_y + j) * linesize]);
+    data_cur  += x + mv_x - me_ctx->mb_size / 2 + (y + mv_y - me_ctx->mb_size / 2) * linesize;
+    data_next += x - mv_x - me_ctx->mb_size / 2 + (y - mv_y - me_ctx->mb_size / 2) * linesize;
+
+    sbad = ff_me_block_sad(me_ctx, data_cur, data_next, me_ctx->mb_size * 3 / 2 + me_ctx->mb_size / 2);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -311,17 +318,17 @@ static uint64_t get_sad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv, i
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x = x_mv - x;
     int mv_y = y_mv - y;
-    int i, j;
-    uint64_t sad = 0;
+    uint64_t sad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     x_mv = av_clip(x_mv, x_min, x_max);
     y_mv = av_clip(y_mv, y_min, y_max);
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sad += FFABS(data_ref[x_mv + i + (y_mv + j) * linesize] - data_cur[x + i + (y + j) * linesize]);
+    data_ref += x_mv - me_ctx->mb_size / 2 + (y_mv - me_ctx->mb_size / 2) * linesize;
+    data_cur += x    - me_ctx->mb_size / 2 + (y    - me_ctx->mb_size / 2) * linesize;
+
+    sad = ff_me_block_sad(me_ctx, data_cur, data_ref, me_ctx->mb_size * 3 / 2 + me_ctx->mb_size / 2);
 
     return sad + (FFABS(mv_x - me_ctx->pred_x) + FFABS(mv_y - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -406,9 +413,9 @@ static int config_output(AVFilterLink *outlink)
         preds.nb++;\
     } while(0)
 
-static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int dir)
+static void search_mv(MIContext *mi_ctx, AVMotionEstContext *me_ctx, Block *blocks,
+                      int mb_x, int mb_y, int dir)
 {
-    AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
     AVMotionEstPredictor *preds = me_ctx->preds;
     Block *block = &blocks[mb_x + mb_y * mi_ctx->b_width];
 
@@ -548,8 +555,72 @@ static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int
     block->mvs[dir][1] = mv[1] - y_mb;
 }
 
-static void bilateral_me(MIContext *mi_ctx)
+static int search_mv_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    AVMotionEstContext me_ctx = mi_ctx->me_ctx;
+    int mb_y_start = 0, mb_y_end = mi_ctx->b_height;
+    int mb_x, mb_y, nb_rows;
+
+    if (td->wave >= 0) {
+        mb_y_start = FFMAX(0, (td->wave - mi_ctx->b_width + 2) >> 1);
+        mb_y_end   = FFMIN(mi_ctx->b_height, (td->wave >> 1) + 1);
+    }
+    nb_rows    = mb_y_end - mb_y_start;
+    mb_y_end   = mb_y_start + nb_rows * (jobnr + 1) / nb_jobs;
+    mb_y_start = mb_y_start + nb_rows *  jobnr      / nb_jobs;
+
+    for (mb_y = mb_y_start; mb_y < mb_y_end; mb_y++) {
+        if (td->wave >= 0)
+            search_mv(mi_ctx, &me_ctx, td->blocks, td->wave - 2 * mb_y, mb_y, td->dir);
+        else
+            for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
+                search_mv(mi_ctx, &me_ctx, td->blocks, mb_x, mb_y, td->dir);
+    }
+
+    /* the costs computed after the search use the predictor of the last
+     * block, as they did when the blocks were searched in raster order */
+    if (mb_y_end == mi_ctx->b_height && mb_y_start < mb_y_end &&
+        (td->wave < 0 || td->wave - 2 * (mb_y_end - 1) == mi_ctx->b_width - 1)) {
+        mi_ctx->me_ctx.pred_x = me_ctx.pred_x;
+        mi_ctx->me_ctx.pred_y = me_ctx.pred_y;
+    }
+
+    emms_c();
+    return 0;
+}
+
+/**
+ * Search the motion vectors of all blocks. EPZS and UMH predict from the
+ * left, top and top right blocks, so with several threads the blocks are
+ * searched in wavefronts: block (x, y) is in wave x + 2 * y, after all the
+ * blocks it depends on.
+ */
+static void search_mvs(AVFilterContext *ctx, Block *blocks, int dir)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData td = { .blocks = blocks, .dir = dir, .wave = -1 };
+    int nb_threads = ff_filter_get_nb_threads(ctx);
+    int nb_waves = mi_ctx->b_width + 2 * (mi_ctx->b_height - 1);
+
+    if (nb_threads > 1 && (mi_ctx->me_method == AV_ME_METHOD_EPZS ||
+                           mi_ctx->me_method == AV_ME_METHOD_UMH)) {
+        for (td.wave = 0; td.wave < nb_waves; td.wave++) {
+            int nb_blocks = FFMIN(mi_ctx->b_height, (td.wave >> 1) + 1) -
+                            FFMAX(0, (td.wave - mi_ctx->b_width + 2) >> 1);
+            ctx->internal->execute(ctx, search_mv_slice, &td, NULL,
+                                   FFMIN(nb_blocks, nb_threads));
+        }
+    } else {
+        ctx->internal->execute(ctx, search_mv_slice, &td, NULL,
+                               FFMIN(mi_ctx->b_height, nb_threads));
+    }
+}
+
+static void bilateral_me(AVFilterContext *ctx)
 {
+    MIContext *mi_ctx = ctx->priv;
     Block *block;
     int mb_x, mb_y;
 
@@ -564,9 +635,7 @@ static void bilateral_me(MIContext *mi_ctx)
             block->mvs[0][1] = 0;
         }
 
-    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-            search_mv(mi_ctx, mi_ctx->int_blocks, mb_x, mb_y, 0);
+    search_mvs(ctx, mi_ctx->int_blocks, 0);
 }
 
 static int var_size_bme(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n)
@@ -750,9 +819,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
                     mi_ctx->me_ctx.data_cur = mi_ctx->frames[2].avf->data[0];
                     mi_ctx->me_ctx.data_ref = mi_ctx->frames[dir ? 3 : 1].avf->data[0];
 
-                    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-                            search_mv(mi_ctx, mi_ctx->frames[2].blocks, mb_x, mb_y, dir);
+                    search_mvs(ctx, mi_ctx->frames[2].blocks, dir);
                 }
             }
 
@@ -767,7 +834,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
             mi_ctx->me_ctx.data_cur = mi_ctx->frames[1].avf->data[0];
             mi_ctx->me_ctx.data_ref = mi_ctx->frames[2].avf->data[0];
 
-            bilateral_me(mi_ctx);
+            bilateral_me(ctx);
 
             if (mi_ctx->mc_mode == MC_MODE_AOBMC) {
 
@@ -779,6 +846,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 
                         block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
                     }
+                emms_c();
             }
 
             if (mi_ctx->vsbmc) {
@@ -799,7 +867,9 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 
                 mi_ctx->clusters[0].nb = mi_ctx->b_count;
 
-                if (ret = cluster_mvs(mi_ctx))
+                ret = cluster_mvs(mi_ctx);
+                emms_c();
+                if (ret)
                     return ret;
             }
         }
@@ -852,17 +922,13 @@ static int detect_scene_change(MIContext *mi_ctx)
         pixel->nb++;\
     } while(0)
 
-static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
+static void bidirectional_obmc(MIContext *mi_ctx, int alpha, int slice_start, int slice_end)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
     int height = mi_ctx->frames[0].avf->height;
     int mb_y, mb_x, dir;
 
-    for (y = 0; y < height; y++)
-        for (x = 0; x < width; x++)
-            mi_ctx->pixels[x + y * width].nb = 0;
-
     for (dir = 0; dir < 2; dir++)
         for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
             for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
@@ -876,9 +942,10 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
                 start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2 + mv_y * a / ALPHA_MAX;
 
                 startc_x = av_clip(start_x, 0, width - 1);
-                startc_y = av_clip(start_y, 0, height - 1);
+                startc_y = av_clip(start_y, slice_start, slice_end);
                 endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
                 endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
+                endc_y = av_clip(endc_y, slice_start, slice_end);
 
                 if (dir) {
                     mv_x = -mv_x;
@@ -900,16 +967,16 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
             }
 }
 
-static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
+static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out,
+                           int slice_start, int slice_end)
 {
     int x, y, plane;
 
     for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
         int width = avf_out->width;
-        int height = avf_out->height;
         int chroma = plane == 1 || plane == 2;
 
-        for (y = 0; y < height; y++)
+        for (y = slice_start; y < slice_end; y++)
             for (x = 0; x < width; x++) {
                 int x_mv, y_mv;
                 int weight_sum = 0;
@@ -956,7 +1023,8 @@ static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
     }
 }
 
-static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha)
+static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha,
+                         int slice_start, int slice_end)
 {
     int sb_x, sb_y;
     int width = mi_ctx->frames[0].avf->width;
@@ -967,16 +1035,17 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
             Block *sb = &block->subs[sb_x + sb_y * 2];
 
             if (sb->sb)
-                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha);
+                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha,
+                             slice_start, slice_end);
             else {
                 int x, y;
                 int mv_x = sb->mvs[0][0] * 2;
                 int mv_y = sb->mvs[0][1] * 2;
 
                 int start_x = x_mb + (sb_x << (n - 1));
-                int start_y = y_mb + (sb_y << (n - 1));
+                int start_y = FFMAX(y_mb + (sb_y << (n - 1)), slice_start);
                 int end_x = start_x + (1 << (n - 1));
-                int end_y = start_y + (1 << (n - 1));
+                int end_y = FFMIN(y_mb + (sb_y << (n - 1)) + (1 << (n - 1)), slice_end);
 
                 for (y = start_y; y < end_y; y++)  {
                     int y_min = -y;
@@ -993,7 +1062,8 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
         }
 }
 
-static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha)
+static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha,
+                           int slice_start, int slice_end)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
@@ -1022,9 +1092,10 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
 
     startc_x = av_clip(start_x, 0, width - 1);
-    startc_y = av_clip(start_y, 0, height - 1);
+    startc_y = av_clip(start_y, slice_start, slice_end);
     endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
     endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
+    endc_y = av_clip(endc_y, slice_start, slice_end);
 
     for (y = startc_y; y < endc_y; y++) {
         int y_min = -y;
@@ -1039,7 +1110,9 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
                 nb_x = (((x - start_x) >> (mi_ctx->log2_mb_size - 1)) * 2 - 3) / 2;
                 nb_y = (((y - start_y) >> (mi_ctx->log2_mb_size - 1)) * 2 - 3) / 2;
 
-                if (nb_x || nb_y) {
+                /* the rows and columns past the last block have no neighbour */
+                if ((nb_x || nb_y) &&
+                    mb_x + nb_x < mi_ctx->b_width && mb_y + nb_y < mi_ctx->b_height) {
                     uint64_t sbad = sbads[nb_x + 1 + (nb_y + 1) * 3];
                     nb = &mi_ctx->int_blocks[mb_x + nb_x + (mb_y + nb_y) * mi_ctx->b_width];
 
@@ -1055,6 +1128,59 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     }
 }
 
+/**
+ * Motion compensate the rows of the interpolated frame handled by job
+ * jobnr. The slices start on chroma rows, so that each chroma sample is
+ * written by a single job.
+ */
+static int mc_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    int width  = mi_ctx->frames[0].avf->width;
+    int height = mi_ctx->frames[0].avf->height;
+    int nb_rows = AV_CEIL_RSHIFT(height, mi_ctx->chroma_v_shift);
+    int slice_start = (nb_rows *  jobnr      / nb_jobs) << mi_ctx->chroma_v_shift;
+    int slice_end   = (nb_rows * (jobnr + 1) / nb_jobs) << mi_ctx->chroma_v_shift;
+    int x, y;
+
+    slice_end = FFMIN(slice_end, height);
+
+    for (y = slice_start; y < slice_end; y++)
+        for (x = 0; x < width; x++)
+            mi_ctx->pixels[x + y * width].nb = 0;
+
+    if (mi_ctx->me_mode == ME_MODE_BIDIR) {
+        bidirectional_obmc(mi_ctx, td->alpha, slice_start, slice_end);
+    } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
+        int mb_x, mb_y;
+        Block *block;
+
+        for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++) {
+            int y_mb = mb_y << mi_ctx->log2_mb_size;
+
+            if (y_mb - mi_ctx->mb_size / 2 >= slice_end ||
+                y_mb + mi_ctx->mb_size * 3 / 2 <= slice_start)
+                continue;
+
+            for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+                block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+                if (block->sb)
+                    var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, y_mb, mi_ctx->log2_mb_size, td->alpha,
+                                 slice_start, slice_end);
+
+                bilateral_obmc(mi_ctx, block, mb_x, mb_y, td->alpha, slice_start, slice_end);
+            }
+        }
+    }
+
+    set_frame_data(mi_ctx, td->alpha, td->avf_out, slice_start, slice_end);
+
+    emms_c();
+    return 0;
+}
+
 static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -1106,34 +1232,14 @@ static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
             }
 
             break;
-        case MI_MODE_MCI:
-            if (mi_ctx->me_mode == ME_MODE_BIDIR) {
-                bidirectional_obmc(mi_ctx, alpha);
-                set_frame_data(mi_ctx, alpha, avf_out);
-
-            } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
-                int mb_x, mb_y;
-                Block *block;
-
-                for (y = 0; y < mi_ctx->frames[0].avf->height; y++)
-                    for (x = 0; x < mi_ctx->frames[0].avf->width; x++)
-                        mi_ctx->pixels[x + y * mi_ctx->frames[0].avf->width].nb = 0;
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
-
-                        if (block->sb)
-                            var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size, mi_ctx->log2_mb_size, alpha);
-
-                        bilateral_obmc(mi_ctx, block, mb_x, mb_y, alpha);
-
-                    }
-
-                set_frame_data(mi_ctx, alpha, avf_out);
-            }
+        case MI_MODE_MCI: {
+            ThreadData td = { .alpha = alpha, .avf_out = avf_out };
+            int nb_rows = AV_CEIL_RSHIFT(avf_out->height, mi_ctx->chroma_v_shift);
 
+            ctx->internal->execute(ctx, mc_slice, &td, NULL,
+                                   FFMIN(nb_rows, ff_filter_get_nb_threads(ctx)));
             break;
+        }
     }
 }
 
@@ -1244,4 +1350,5 @@ AVFilter ff_vf_minterpolate = {
     .query_formats = query_formats,
     .inputs        = minterpolate_inputs,
     .outputs       = minterpolate_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -22,13 +22,13 @@
 #include <float.h>
 
 #include "libavutil/common.h"
-#include "libavutil/float_dsp.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "nnedi.h"
 #include "video.h"
 
 typedef struct FrameData {
@@ -43,8 +43,8 @@ typedef struct FrameData {
     int field[3];
 
     int32_t *lcount[3];
-    float *input;
-    float *temp;
+    float **input;  ///< per slice job
+    float **temp;   ///< per slice job
 } FrameData;
 
 typedef struct NNEDIContext {
@@ -58,7 +58,8 @@ typedef struct NNEDIContext {
     int eof;
     int64_t cur_pts;
 
-    AVFloatDSPContext *fdsp;
+    NNEDIDSPContext dsp;
+    int nb_threads;
     int nb_planes;
     int linesize[4];
     int planeheight[4];
@@ -84,8 +85,8 @@ typedef struct NNEDIContext {
     int max_value;
 
     void (*copy_pad)(const AVFrame *, FrameData *, struct NNEDIContext *, int);
-    void (*evalfunc_0)(struct NNEDIContext *, FrameData *);
-    void (*evalfunc_1)(struct NNEDIContext *, FrameData *);
+    void (*evalfunc_0)(struct NNEDIContext *, FrameData *, int jobnr, int nb_jobs);
+    void (*evalfunc_1)(struct NNEDIContext *, FrameData *, int jobnr, int nb_jobs);
 
     // Functions used in evalfunc_0
     void (*readpixels)(const uint8_t *, const int, float *);
@@ -152,7 +153,9 @@ static int config_input(AVFilterLink *inlink)
     AVFilterContext *ctx = inlink->dst;
     NNEDIContext *s = ctx->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
-    int ret;
+    FrameData *frame_data = &s->frame_data;
+    size_t temp_size;
+    int i, ret;
 
     s->nb_planes = av_pix_fmt_count_planes(inlink->format);
     if ((ret = av_image_fill_linesizes(s->linesize, inlink->format, inlink->w)) < 0)
@@ -161,6 +164,22 @@ static int config_input(AVFilterLink *inlink)
     s->planeheight[1] = s->planeheight[2] = AV_CEIL_RSHIFT(inlink->h, desc->log2_chroma_h);
     s->planeheight[0] = s->planeheight[3] = inlink->h;
 
+    s->nb_threads = FFMAX(1, FFMIN(ff_filter_get_nb_threads(ctx), inlink->h / 2));
+    frame_data->input = av_calloc(s->nb_threads, sizeof(*frame_data->input));
+    frame_data->temp  = av_calloc(s->nb_threads, sizeof(*frame_data->temp));
+    if (!frame_data->input || !frame_data->temp)
+        return AVERROR(ENOMEM);
+
+    // evalfunc_0 requires at least padded_width[0] bytes.
+    // evalfunc_1 requires at least 512 floats.
+    temp_size = FFMAX(s->linesize[0] + 64, 512 * sizeof(float));
+    for (i = 0; i < s->nb_threads; i++) {
+        frame_data->input[i] = av_malloc(512 * sizeof(float));
+        frame_data->temp[i]  = av_malloc(temp_size);
+        if (!frame_data->input[i] || !frame_data->temp[i])
+            return AVERROR(ENOMEM);
+    }
+
     return 0;
 }
 
@@ -265,19 +284,25 @@ static void elliott(float *data, const int n)
         data[i] = data[i] / (1.0f + FFABS(data[i]));
 }
 
-static void dot_prod(NNEDIContext *s, const float *data, const float *weights, float *vals, const int n, const int len, const float *scale)
+static void dot_prod_c(const float *data, const float *weights, float *vals, int n, int len, float scale)
 {
-    int i;
+    int i, j;
 
     for (i = 0; i < n; i++) {
-        float sum;
+        float sum = 0.0f;
 
-        sum = s->fdsp->scalarproduct_float(data, &weights[i * len], len);
+        for (j = 0; j < len; j++)
+            sum += data[j] * weights[i * len + j];
 
-        vals[i] = sum * scale[0] + weights[n * len + i];
+        vals[i] = sum * scale + weights[n * len + i];
     }
 }
 
+static void dot_prod(NNEDIContext *s, const float *data, const float *weights, float *vals, const int n, const int len, const float *scale)
+{
+    s->dsp.dot_prod(data, weights, vals, n, len, scale[0]);
+}
+
 static void dot_prods(NNEDIContext *s, const float *dataf, const float *weightsf, float *vals, const int n, const int len, const float *scale)
 {
     const int16_t *data = (int16_t *)dataf;
@@ -415,11 +440,16 @@ static void compute_network0new(NNEDIContext *s, const float *datai, const float
     ((int *)d)[0] = mask;
 }
 
-static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
+/* First output row of a slice job. Slices start on even rows so that each
+ * job handles the same field parity as the whole frame. */
+#define SLICE_START(h, jobnr, nb_jobs) \
+    ((jobnr) == (nb_jobs) ? (h) : ((h) * (jobnr) / (nb_jobs)) & ~1)
+
+static void evalfunc_0(NNEDIContext *s, FrameData *frame_data, int jobnr, int nb_jobs)
 {
-    float *input = frame_data->input;
+    float *input = frame_data->input[jobnr];
     const float *weights0 = s->weights0;
-    float *temp = frame_data->temp;
+    float *temp = frame_data->temp[jobnr];
     uint8_t *tempu = (uint8_t *)temp;
     int plane, x, y;
 
@@ -433,6 +463,8 @@ static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
 
         uint8_t *dstp = (uint8_t *)frame_data->dstp[plane];
         const int dst_stride = frame_data->dst_stride[plane] / sizeof(uint8_t);
+        const int slice_start = SLICE_START(height - 12, jobnr, nb_jobs);
+        const int slice_end   = SLICE_START(height - 12, jobnr + 1, nb_jobs);
         const uint8_t *src3p;
         int ystart, ystop;
         int32_t *lcount;
@@ -440,15 +472,15 @@ static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
         if (!(s->process_plane & (1 << plane)))
             continue;
 
-        for (y = 1 - frame_data->field[plane]; y < height - 12; y += 2) {
+        for (y = slice_start + 1 - frame_data->field[plane]; y < slice_end; y += 2) {
             memcpy(dstp + y * dst_stride,
                    srcp + 32 + (6 + y) * src_stride,
                    (width - 64) * sizeof(uint8_t));
 
         }
 
-        ystart = 6 + frame_data->field[plane];
-        ystop = height - 6;
+        ystart = 6 + slice_start + frame_data->field[plane];
+        ystop = 6 + slice_end;
         srcp += ystart * src_stride;
         dstp += (ystart - 6) * dst_stride - 32;
         src3p = srcp - src_stride * 3;
@@ -549,7 +581,7 @@ static void extract_m8_i16(const uint8_t *srcp, const int stride, const int xdia
 static const float exp_lo = -80.0f;
 static const float exp_hi = +80.0f;
 
-static void e2_m16(float *s, const int n)
+static void e2_m16(float *s, int n)
 {
     int i;
 
@@ -557,6 +589,15 @@ static void e2_m16(float *s, const int n)
         s[i] = exp(av_clipf(s[i], exp_lo, exp_hi));
 }
 
+av_cold void ff_nnedi_init(NNEDIDSPContext *dsp)
+{
+    dsp->dot_prod = dot_prod_c;
+    dsp->expfunc  = e2_m16;
+
+    if (ARCH_X86)
+        ff_nnedi_init_x86(dsp);
+}
+
 const float min_weight_sum = 1e-10f;
 
 static void weighted_avg_elliott_mul5_m16(const float *w, const int n, float *mstd)
@@ -575,10 +616,10 @@ static void weighted_avg_elliott_mul5_m16(const float *w, const int n, float *ms
 }
 
 
-static void evalfunc_1(NNEDIContext *s, FrameData *frame_data)
+static void evalfunc_1(NNEDIContext *s, FrameData *frame_data, int jobnr, int nb_jobs)
 {
-    float *input = frame_data->input;
-    float *temp = frame_data->temp;
+    float *input = frame_data->input[jobnr];
+    float *temp = frame_data->temp[jobnr];
     float **weights1 = s->weights1;
     const int qual = s->qual;
     const int asize = s->asize;
@@ -599,8 +640,8 @@ static void evalfunc_1(NNEDIContext *s, FrameData *frame_data)
         uint8_t *dstp = (uint8_t *)frame_data->dstp[plane];
         const int dst_stride = frame_data->dst_stride[plane] / sizeof(uint8_t);
 
-        const int ystart = frame_data->field[plane];
-        const int ystop = height - 12;
+        const int ystart = SLICE_START(height - 12, jobnr, nb_jobs) + frame_data->field[plane];
+        const int ystop = SLICE_START(height - 12, jobnr + 1, nb_jobs);
         const uint8_t *srcpp;
 
         if (!(s->process_plane & (1 << plane)))
@@ -676,7 +717,7 @@ static void select_functions(NNEDIContext *s)
         s->dot_prod = dot_prod;
     }
 
-    s->expfunc = e2_m16;
+    s->expfunc = s->dsp.expfunc;
 }
 
 static int modnpf(const int m, const int n)
@@ -686,6 +727,20 @@ static int modnpf(const int m, const int n)
     return m + n - (m % n);
 }
 
+static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    NNEDIContext *s = ctx->priv;
+    FrameData *frame_data = arg;
+
+    // Handles prescreening and the cubic interpolation.
+    s->evalfunc_0(s, frame_data, jobnr, nb_jobs);
+
+    // The rest.
+    s->evalfunc_1(s, frame_data, jobnr, nb_jobs);
+
+    return 0;
+}
+
 static int get_frame(AVFilterContext *ctx, int is_second)
 {
     NNEDIContext *s = ctx->priv;
@@ -693,7 +748,6 @@ static int get_frame(AVFilterContext *ctx, int is_second)
     AVFrame *src = s->src;
     FrameData *frame_data;
     int effective_field = s->field;
-    size_t temp_size;
     int field_n;
     int plane;
 
@@ -765,28 +819,10 @@ static int get_frame(AVFilterContext *ctx, int is_second)
         frame_data->field[plane] = field_n;
     }
 
-    if (!frame_data->input) {
-        frame_data->input = av_malloc(512 * sizeof(float));
-        if (!frame_data->input)
-            return AVERROR(ENOMEM);
-    }
-    // evalfunc_0 requires at least padded_width[0] bytes.
-    // evalfunc_1 requires at least 512 floats.
-    if (!frame_data->temp) {
-        temp_size = FFMAX(frame_data->padded_width[0], 512 * sizeof(float));
-        frame_data->temp = av_malloc(temp_size);
-        if (!frame_data->temp)
-            return AVERROR(ENOMEM);
-    }
-
     // Copy src to a padded "frame" in frame_data and mirror the edges.
     s->copy_pad(src, frame_data, s, field_n);
 
-    // Handles prescreening and the cubic interpolation.
-    s->evalfunc_0(s, frame_data);
-
-    // The rest.
-    s->evalfunc_1(s, frame_data);
+    ctx->internal->execute(ctx, filter_slice, frame_data, NULL, s->nb_threads);
 
     return 0;
 }
@@ -1145,12 +1181,9 @@ static av_cold int init(AVFilterContext *ctx)
 
     s->max_value = 65535 >> 8;
 
+    ff_nnedi_init(&s->dsp);
     select_functions(s);
 
-    s->fdsp = avpriv_float_dsp_alloc(0);
-    if (!s->fdsp)
-        ret = AVERROR(ENOMEM);
-
 fail:
     av_free(bdata);
     return ret;
@@ -1171,9 +1204,14 @@ static av_cold void uninit(AVFilterContext *ctx)
         av_freep(&s->frame_data.lcount[i]);
     }
 
+    for (i = 0; i < s->nb_threads; i++) {
+        if (s->frame_data.input)
+            av_freep(&s->frame_data.input[i]);
+        if (s->frame_data.temp)
+            av_freep(&s->frame_data.temp[i]);
+    }
     av_freep(&s->frame_data.input);
     av_freep(&s->frame_data.temp);
-    av_freep(&s->fdsp);
     av_frame_free(&s->second);
 }
 
@@ -1207,5 +1245,5 @@ AVFilter ff_vf_nnedi = {
     .query_formats = query_formats,
     .inputs        = inputs,
     .outputs       = outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -38,6 +38,7 @@
 #include "internal.h"
 #include "dualinput.h"
 #include "drawutils.h"
+#include "overlay.h"
 #include "video.h"
 
 static const char *const var_names[] = {
@@ -132,6 +133,8 @@ typedef struct OverlayContext {
     int eof_action;             ///< action to take on EOF from source
 
     AVExpr *x_pexpr, *y_pexpr;
+
+    OverlayDSPContext dsp;
 } OverlayContext;
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -394,195 +397,309 @@ static int config_output(AVFilterLink *outlink)
 // ((((x) + (y)) << 8) - ((x) + (y)) - (y) * (x)) is a faster version of: 255 * (x + y)
 #define UNPREMULTIPLY_ALPHA(x, y) ((((x) << 16) - ((x) << 9) + (x)) / ((((x) + (y)) << 8) - ((x) + (y)) - (y) * (x)))
 
-/**
- * Blend image in src to destination buffer dst at position (x, y).
- */
-static void blend_image(AVFilterContext *ctx,
-                        AVFrame *dst, const AVFrame *src,
-                        int x, int y)
+static void blend_row_c(uint8_t *d, const uint8_t *s, const uint8_t *a, int w)
+{
+    int k;
+
+    for (k = 0; k < w; k++)
+        d[k] = FAST_DIV255(d[k] * (255 - a[k]) + s[k] * a[k]);
+}
+
+static void blend_row_420_c(uint8_t *d, const uint8_t *s, const uint8_t *a,
+                            ptrdiff_t alpha_linesize, int w)
+{
+    int k;
+
+    for (k = 0; k < w; k++) {
+        int alpha = (a[2 * k]                  + a[2 * k + 1] +
+                     a[2 * k + alpha_linesize] + a[2 * k + alpha_linesize + 1]) >> 2;
+        d[k] = FAST_DIV255(d[k] * (255 - alpha) + s[k] * alpha);
+    }
+}
+
+av_cold void ff_overlay_init(OverlayDSPContext *dsp)
+{
+    dsp->blend_row     = blend_row_c;
+    dsp->blend_row_420 = blend_row_420_c;
+
+    if (ARCH_X86)
+        ff_overlay_init_x86(dsp);
+}
+
+typedef struct ThreadData {
+    AVFrame *dst;
+    const AVFrame *src;
+} ThreadData;
+
+/* Rows [*start, *end) of the rows [start, end) handled by job jobnr. */
+static void slice_rows(int *start, int *end, int jobnr, int nb_jobs)
+{
+    int rows = *end - *start;
+
+    *end   = *start + rows * (jobnr + 1) / nb_jobs;
+    *start = *start + rows *  jobnr      / nb_jobs;
+}
+
+static void blend_packed_rgb(AVFilterContext *ctx,
+                             AVFrame *dst, const AVFrame *src,
+                             int x, int y, int jobnr, int nb_jobs)
 {
     OverlayContext *s = ctx->priv;
-    int i, imax, j, jmax, k, kmax;
+    int i, imax, j, jmax;
     const int src_w = src->width;
     const int src_h = src->height;
     const int dst_w = dst->width;
     const int dst_h = dst->height;
+    uint8_t alpha;          ///< the amount of overlay to blend on to main
+    const int dr = s->main_rgba_map[R];
+    const int dg = s->main_rgba_map[G];
+    const int db = s->main_rgba_map[B];
+    const int da = s->main_rgba_map[A];
+    const int dstep = s->main_pix_step[0];
+    const int sr = s->overlay_rgba_map[R];
+    const int sg = s->overlay_rgba_map[G];
+    const int sb = s->overlay_rgba_map[B];
+    const int sa = s->overlay_rgba_map[A];
+    const int sstep = s->overlay_pix_step[0];
+    const int main_has_alpha = s->main_has_alpha;
+    uint8_t *S, *sp, *d, *dp;
+
+    i    = FFMAX(-y, 0);
+    imax = FFMIN(-y + dst_h, src_h);
+    slice_rows(&i, &imax, jobnr, nb_jobs);
+    sp = src->data[0] + i     * src->linesize[0];
+    dp = dst->data[0] + (y+i) * dst->linesize[0];
+
+    for (; i < imax; i++) {
+        j = FFMAX(-x, 0);
+        S = sp + j     * sstep;
+        d = dp + (x+j) * dstep;
+
+        for (jmax = FFMIN(-x + dst_w, src_w); j < jmax; j++) {
+            alpha = S[sa];
+
+            // if the main channel has an alpha channel, alpha has to be calculated
+            // to create an un-premultiplied (straight) alpha value
+            if (main_has_alpha && alpha != 0 && alpha != 255) {
+                uint8_t alpha_d = d[da];
+                alpha = UNPREMULTIPLY_ALPHA(alpha, alpha_d);
+            }
 
-    if (x >= dst_w || x+src_w < 0 ||
-        y >= dst_h || y+src_h < 0)
-        return; /* no intersection */
-
-    if (s->main_is_packed_rgb) {
-        uint8_t alpha;          ///< the amount of overlay to blend on to main
-        const int dr = s->main_rgba_map[R];
-        const int dg = s->main_rgba_map[G];
-        const int db = s->main_rgba_map[B];
-        const int da = s->main_rgba_map[A];
-        const int dstep = s->main_pix_step[0];
-        const int sr = s->overlay_rgba_map[R];
-        const int sg = s->overlay_rgba_map[G];
-        const int sb = s->overlay_rgba_map[B];
-        const int sa = s->overlay_rgba_map[A];
-        const int sstep = s->overlay_pix_step[0];
-        const int main_has_alpha = s->main_has_alpha;
-        uint8_t *s, *sp, *d, *dp;
-
-        i = FFMAX(-y, 0);
-        sp = src->data[0] + i     * src->linesize[0];
-        dp = dst->data[0] + (y+i) * dst->linesize[0];
-
-        for (imax = FFMIN(-y + dst_h, src_h); i < imax; i++) {
-            j = FFMAX(-x, 0);
-            s = sp + j     * sstep;
-            d = dp + (x+j) * dstep;
-
-            for (jmax = FFMIN(-x + dst_w, src_w); j < jmax; j++) {
-                alpha = s[sa];
-
-                // if the main channel has an alpha channel, alpha has to be calculated
-                // to create an un-premultiplied (straight) alpha value
-                if (main_has_alpha && alpha != 0 && alpha != 255) {
-                    uint8_t alpha_d = d[da];
-                    alpha = UNPREMULTIPLY_ALPHA(alpha, alpha_d);
-                }
-
+            switch (alpha) {
+            case 0:
+                break;
+            case 255:
+                d[dr] = S[sr];
+                d[dg] = S[sg];
+                d[db] = S[sb];
+                break;
+            default:
+                // main_value = main_value * (1 - alpha) + overlay_value * alpha
+                // since alpha is in the range 0-255, the result must divided by 255
+                d[dr] = FAST_DIV255(d[dr] * (255 - alpha) + S[sr] * alpha);
+                d[dg] = FAST_DIV255(d[dg] * (255 - alpha) + S[sg] * alpha);
+                d[db] = FAST_DIV255(d[db] * (255 - alpha) + S[sb] * alpha);
+            }
+            if (main_has_alpha) {
                 switch (alpha) {
                 case 0:
                     break;
                 case 255:
-                    d[dr] = s[sr];
-                    d[dg] = s[sg];
-                    d[db] = s[sb];
+                    d[da] = S[sa];
                     break;
                 default:
-                    // main_value = main_value * (1 - alpha) + overlay_value * alpha
-                    // since alpha is in the range 0-255, the result must divided by 255
-                    d[dr] = FAST_DIV255(d[dr] * (255 - alpha) + s[sr] * alpha);
-                    d[dg] = FAST_DIV255(d[dg] * (255 - alpha) + s[sg] * alpha);
-                    d[db] = FAST_DIV255(d[db] * (255 - alpha) + s[sb] * alpha);
-                }
-                if (main_has_alpha) {
-                    switch (alpha) {
-                    case 0:
-                        break;
-                    case 255:
-                        d[da] = s[sa];
-                        break;
-                    default:
-                        // apply alpha compositing: main_alpha += (1-main_alpha) * overlay_alpha
-                        d[da] += FAST_DIV255((255 - d[da]) * s[sa]);
-                    }
+                    // apply alpha compositing: main_alpha += (1-main_alpha) * overlay_alpha
+                    d[da] += FAST_DIV255((255 - d[da]) * S[sa]);
                 }
-                d += dstep;
-                s += sstep;
             }
-            dp += dst->linesize[0];
-            sp += src->linesize[0];
+            d += dstep;
+            S += sstep;
         }
-    } else {
-        const int main_has_alpha = s->main_has_alpha;
-        if (main_has_alpha) {
-            uint8_t alpha;          ///< the amount of overlay to blend on to main
-            uint8_t *s, *sa, *d, *da;
-
-            i = FFMAX(-y, 0);
-            sa = src->data[3] + i     * src->linesize[3];
-            da = dst->data[3] + (y+i) * dst->linesize[3];
-
-            for (imax = FFMIN(-y + dst_h, src_h); i < imax; i++) {
-                j = FFMAX(-x, 0);
-                s = sa + j;
-                d = da + x+j;
-
-                for (jmax = FFMIN(-x + dst_w, src_w); j < jmax; j++) {
-                    alpha = *s;
-                    if (alpha != 0 && alpha != 255) {
-                        uint8_t alpha_d = *d;
-                        alpha = UNPREMULTIPLY_ALPHA(alpha, alpha_d);
-                    }
-                    switch (alpha) {
-                    case 0:
-                        break;
-                    case 255:
-                        *d = *s;
-                        break;
-                    default:
-                        // apply alpha compositing: main_alpha += (1-main_alpha) * overlay_alpha
-                        *d += FAST_DIV255((255 - *d) * *s);
-                    }
-                    d += 1;
-                    s += 1;
-                }
-                da += dst->linesize[3];
-                sa += src->linesize[3];
+        dp += dst->linesize[0];
+        sp += src->linesize[0];
+    }
+}
+
+static void blend_alpha_plane(AVFrame *dst, const AVFrame *src, int x, int y)
+{
+    int i, imax, j, jmax;
+    const int src_w = src->width;
+    const int src_h = src->height;
+    const int dst_w = dst->width;
+    const int dst_h = dst->height;
+    uint8_t alpha;          ///< the amount of overlay to blend on to main
+    uint8_t *s, *sa, *d, *da;
+
+    i = FFMAX(-y, 0);
+    sa = src->data[3] + i     * src->linesize[3];
+    da = dst->data[3] + (y+i) * dst->linesize[3];
+
+    for (imax = FFMIN(-y + dst_h, src_h); i < imax; i++) {
+        j = FFMAX(-x, 0);
+        s = sa + j;
+        d = da + x+j;
+
+        for (jmax = FFMIN(-x + dst_w, src_w); j < jmax; j++) {
+            alpha = *s;
+            if (alpha != 0 && alpha != 255) {
+                uint8_t alpha_d = *d;
+                alpha = UNPREMULTIPLY_ALPHA(alpha, alpha_d);
+            }
+            switch (alpha) {
+            case 0:
+                break;
+            case 255:
+                *d = *s;
+                break;
+            default:
+                // apply alpha compositing: main_alpha += (1-main_alpha) * overlay_alpha
+                *d += FAST_DIV255((255 - *d) * *s);
             }
+            d += 1;
+            s += 1;
         }
-        for (i = 0; i < 3; i++) {
-            int hsub = i ? s->hsub : 0;
-            int vsub = i ? s->vsub : 0;
-            int src_wp = AV_CEIL_RSHIFT(src_w, hsub);
-            int src_hp = AV_CEIL_RSHIFT(src_h, vsub);
-            int dst_wp = AV_CEIL_RSHIFT(dst_w, hsub);
-            int dst_hp = AV_CEIL_RSHIFT(dst_h, vsub);
-            int yp = y>>vsub;
-            int xp = x>>hsub;
-            uint8_t *s, *sp, *d, *dp, *a, *ap;
-
-            j = FFMAX(-yp, 0);
-            sp = src->data[i] + j         * src->linesize[i];
-            dp = dst->data[i] + (yp+j)    * dst->linesize[i];
-            ap = src->data[3] + (j<<vsub) * src->linesize[3];
-
-            for (jmax = FFMIN(-yp + dst_hp, src_hp); j < jmax; j++) {
-                k = FFMAX(-xp, 0);
-                d = dp + xp+k;
-                s = sp + k;
-                a = ap + (k<<hsub);
-
-                for (kmax = FFMIN(-xp + dst_wp, src_wp); k < kmax; k++) {
-                    int alpha_v, alpha_h, alpha;
-
-                    // average alpha for color components, improve quality
-                    if (hsub && vsub && j+1 < src_hp && k+1 < src_wp) {
-                        alpha = (a[0] + a[src->linesize[3]] +
-                                 a[1] + a[src->linesize[3]+1]) >> 2;
-                    } else if (hsub || vsub) {
-                        alpha_h = hsub && k+1 < src_wp ?
-                            (a[0] + a[1]) >> 1 : a[0];
-                        alpha_v = vsub && j+1 < src_hp ?
-                            (a[0] + a[src->linesize[3]]) >> 1 : a[0];
-                        alpha = (alpha_v + alpha_h) >> 1;
-                    } else
-                        alpha = a[0];
-                    // if the main channel has an alpha channel, alpha has to be calculated
-                    // to create an un-premultiplied (straight) alpha value
-                    if (main_has_alpha && alpha != 0 && alpha != 255) {
-                        // average alpha for color components, improve quality
-                        uint8_t alpha_d;
-                        if (hsub && vsub && j+1 < src_hp && k+1 < src_wp) {
-                            alpha_d = (d[0] + d[src->linesize[3]] +
-                                       d[1] + d[src->linesize[3]+1]) >> 2;
-                        } else if (hsub || vsub) {
-                            alpha_h = hsub && k+1 < src_wp ?
-                                (d[0] + d[1]) >> 1 : d[0];
-                            alpha_v = vsub && j+1 < src_hp ?
-                                (d[0] + d[src->linesize[3]]) >> 1 : d[0];
-                            alpha_d = (alpha_v + alpha_h) >> 1;
-                        } else
-                            alpha_d = d[0];
-                        alpha = UNPREMULTIPLY_ALPHA(alpha, alpha_d);
-                    }
-                    *d = FAST_DIV255(*d * (255 - alpha) + *s * alpha);
-                    s++;
-                    d++;
-                    a += 1 << hsub;
-                }
-                dp += dst->linesize[i];
-                sp += src->linesize[i];
-                ap += (1 << vsub) * src->linesize[3];
+        da += dst->linesize[3];
+        sa += src->linesize[3];
+    }
+}
+
+static void blend_plane(AVFilterContext *ctx,
+                        AVFrame *dst, const AVFrame *src,
+                        int i, int x, int y, int jobnr, int nb_jobs)
+{
+    OverlayContext *s = ctx->priv;
+    const int main_has_alpha = s->main_has_alpha;
+    int j, jmax, k, kmax;
+    int hsub = i ? s->hsub : 0;
+    int vsub = i ? s->vsub : 0;
+    int src_wp = AV_CEIL_RSHIFT(src->width,  hsub);
+    int src_hp = AV_CEIL_RSHIFT(src->height, vsub);
+    int dst_wp = AV_CEIL_RSHIFT(dst->width,  hsub);
+    int dst_hp = AV_CEIL_RSHIFT(dst->height, vsub);
+    int yp = y>>vsub;
+    int xp = x>>hsub;
+    uint8_t *S, *sp, *d, *dp, *a, *ap;
+
+    j    = FFMAX(-yp, 0);
+    jmax = FFMIN(-yp + dst_hp, src_hp);
+    slice_rows(&j, &jmax, jobnr, nb_jobs);
+    sp = src->data[i] + j         * src->linesize[i];
+    dp = dst->data[i] + (yp+j)    * dst->linesize[i];
+    ap = src->data[3] + (j<<vsub) * src->linesize[3];
+
+    for (; j < jmax; j++) {
+        k = FFMAX(-xp, 0);
+        kmax = FFMIN(-xp + dst_wp, src_wp);
+        d = dp + xp+k;
+        S = sp + k;
+        a = ap + (k<<hsub);
+
+        if (!main_has_alpha) {
+            int n = 0;
+
+            /* the last column and row of subsampled planes average alpha
+             * differently, they are left to the loop below */
+            if (!hsub && !vsub)
+                n = FFMAX(kmax - k, 0) & ~15;
+            else if (hsub && vsub && j+1 < src_hp)
+                n = FFMAX(FFMIN(kmax, src_wp - 1) - k, 0) & ~15;
+            if (n) {
+                if (hsub)
+                    s->dsp.blend_row_420(d, S, a, src->linesize[3], n);
+                else
+                    s->dsp.blend_row(d, S, a, n);
+                k += n;
+                d += n;
+                S += n;
+                a += n << hsub;
+            }
+        }
+
+        for (; k < kmax; k++) {
+            int alpha_v, alpha_h, alpha;
+
+            // average alpha for color components, improve quality
+            if (hsub && vsub && j+1 < src_hp && k+1 < src_wp) {
+                alpha = (a[0] + a[src->linesize[3]] +
+                         a[1] + a[src->linesize[3]+1]) >> 2;
+            } else if (hsub || vsub) {
+                alpha_h = hsub && k+1 < src_wp ?
+                    (a[0] + a[1]) >> 1 : a[0];
+                alpha_v = vsub && j+1 < src_hp ?
+                    (a[0] + a[src->linesize[3]]) >> 1 : a[0];
+                alpha = (alpha_v + alpha_h) >> 1;
+            } else
+                alpha = a[0];
+            // if the main channel has an alpha channel, alpha has to be calculated
+            // to create an un-premultiplied (straight) alpha value
+            if (main_has_alpha && alpha != 0 && alpha != 255) {
+                // average alpha for color components, improve quality
+                uint8_t alpha_d;
+                if (hsub && vsub && j+1 < src_hp && k+1 < src_wp) {
+                    alpha_d = (d[0] + d[src->linesize[3]] +
+                               d[1] + d[src->linesize[3]+1]) >> 2;
+                } else if (hsub || vsub) {
+                    alpha_h = hsub && k+1 < src_wp ?
+                        (d[0] + d[1]) >> 1 : d[0];
+                    alpha_v = vsub && j+1 < src_hp ?
+                        (d[0] + d[src->linesize[3]]) >> 1 : d[0];
+                    alpha_d = (alpha_v + alpha_h) >> 1;
+                } else
+                    alpha_d = d[0];
+                alpha = UNPREMULTIPLY_ALPHA(alpha, alpha_d);
             }
+            *d = FAST_DIV255(*d * (255 - alpha) + *S * alpha);
+            S++;
+            d++;
+            a += 1 << hsub;
         }
+        dp += dst->linesize[i];
+        sp += src->linesize[i];
+        ap += (1 << vsub) * src->linesize[3];
+    }
+}
+
+/**
+ * Blend image in src to destination buffer dst at position (x, y), the
+ * rows of job jobnr out of nb_jobs.
+ */
+static int blend_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    OverlayContext *s = ctx->priv;
+    ThreadData *td = arg;
+    int i;
+
+    if (s->main_is_packed_rgb) {
+        blend_packed_rgb(ctx, td->dst, td->src, s->x, s->y, jobnr, nb_jobs);
+    } else {
+        if (s->main_has_alpha)
+            blend_alpha_plane(td->dst, td->src, s->x, s->y);
+        for (i = 0; i < 3; i++)
+            blend_plane(ctx, td->dst, td->src, i, s->x, s->y, jobnr, nb_jobs);
     }
+    return 0;
+}
+
+static void blend_image(AVFilterContext *ctx,
+                        AVFrame *dst, const AVFrame *src,
+                        int x, int y)
+{
+    OverlayContext *s = ctx->priv;
+    ThreadData td = { .dst = dst, .src = src };
+    int nb_jobs;
+
+    if (x >= dst->width  || x+src->width  < 0 ||
+        y >= dst->height || y+src->height < 0)
+        return; /* no intersection */
+
+    /* With an alpha plane in main, the color planes read main pixels of
+     * the following row as alpha, so their rows are not independent. */
+    if (!s->main_is_packed_rgb && s->main_has_alpha)
+        nb_jobs = 1;
+    else
+        nb_jobs = FFMIN(src->height, ff_filter_get_nb_threads(ctx));
+
+    ctx->internal->execute(ctx, blend_slice, &td, NULL, nb_jobs);
 }
 
 static AVFrame *do_blend(AVFilterContext *ctx, AVFrame *mainpic,
@@ -594,7 +711,7 @@ static AVFrame *do_blend(AVFilterContext *ctx, AVFrame *mainpic,
     if (s->eval_mode == EVAL_MODE_FRAME) {
         int64_t pos = av_frame_get_pkt_pos(mainpic);
 
-        s->var_values[VAR_N] = inlink->frame_count;
+        s->var_values[VAR_N] = inlink->frame_count_out;
         s->var_values[VAR_T] = mainpic->pts == AV_NOPTS_VALUE ?
             NAN : mainpic->pts * av_q2d(inlink->time_base);
         s->var_values[VAR_POS] = pos == -1 ? NAN : pos;
@@ -647,6 +764,7 @@ static av_cold int init(AVFilterContext *ctx)
     }
 
     s->dinput.process = do_blend;
+    ff_overlay_init(&s->dsp);
     return 0;
 }
 
@@ -716,5 +834,6 @@ AVFilter ff_vf_overlay = {
     .process_command = process_command,
     .inputs        = avfilter_vf_overlay_inputs,
     .outputs       = avfilter_vf_overlay_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
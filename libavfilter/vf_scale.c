@@ -82,6 +82,8 @@ typedef struct ScaleContext {
     const AVClass *class;
     struct SwsContext *sws;     ///< software scaler context
     struct SwsContext *isws[2]; ///< software scaler context for interlaced material
+    struct SwsContext **tsws;   ///< additional scaler contexts for slice threading, sws is used by the first job
+    int nb_tsws;
     AVDictionary *opts;
 
     /**
@@ -124,6 +126,10 @@ typedef struct ScaleContext {
 
 } ScaleContext;
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
 AVFilter ff_vf_scale2ref;
 
 static av_cold int init_dict(AVFilterContext *ctx, AVDictionary **opts)
@@ -176,12 +182,23 @@ static av_cold int init_dict(AVFilterContext *ctx, AVDictionary **opts)
     return 0;
 }
 
+static void free_thread_contexts(ScaleContext *scale)
+{
+    int i;
+
+    for (i = 0; i < scale->nb_tsws; i++)
+        sws_freeContext(scale->tsws[i]);
+    av_freep(&scale->tsws);
+    scale->nb_tsws = 0;
+}
+
 static av_cold void uninit(AVFilterContext *ctx)
 {
     ScaleContext *scale = ctx->priv;
     sws_freeContext(scale->sws);
     sws_freeContext(scale->isws[0]);
     sws_freeContext(scale->isws[1]);
+    free_thread_contexts(scale);
     scale->sws = NULL;
     av_dict_free(&scale->opts);
 }
@@ -248,6 +265,59 @@ static const int *parse_yuv_type(const char *s, enum AVColorSpace colorspace)
     return sws_getCoefficients(colorspace);
 }
 
+static int init_sws_context(AVFilterContext *ctx, struct SwsContext **s, int i,
+                            AVFilterLink *inlink0, AVFilterLink *outlink,
+                            enum AVPixelFormat outfmt)
+{
+    ScaleContext *scale = ctx->priv;
+    int ret;
+
+    *s = sws_alloc_context();
+    if (!*s)
+        return AVERROR(ENOMEM);
+
+    av_opt_set_int(*s, "srcw", inlink0 ->w, 0);
+    av_opt_set_int(*s, "srch", inlink0 ->h >> !!i, 0);
+    av_opt_set_int(*s, "src_format", inlink0->format, 0);
+    av_opt_set_int(*s, "dstw", outlink->w, 0);
+    av_opt_set_int(*s, "dsth", outlink->h >> !!i, 0);
+    av_opt_set_int(*s, "dst_format", outfmt, 0);
+    av_opt_set_int(*s, "sws_flags", scale->flags, 0);
+    av_opt_set_int(*s, "param0", scale->param[0], 0);
+    av_opt_set_int(*s, "param1", scale->param[1], 0);
+    if (scale->in_range != AVCOL_RANGE_UNSPECIFIED)
+        av_opt_set_int(*s, "src_range",
+                       scale->in_range == AVCOL_RANGE_JPEG, 0);
+    if (scale->out_range != AVCOL_RANGE_UNSPECIFIED)
+        av_opt_set_int(*s, "dst_range",
+                       scale->out_range == AVCOL_RANGE_JPEG, 0);
+
+    if (scale->opts) {
+        AVDictionaryEntry *e = NULL;
+        while ((e = av_dict_get(scale->opts, "", e, AV_DICT_IGNORE_SUFFIX))) {
+            if ((ret = av_opt_set(*s, e->key, e->value, 0)) < 0)
+                return ret;
+        }
+    }
+    /* Override YUV420P default settings to have the correct (MPEG-2) chroma positions
+     * MPEG-2 chroma positions are used by convention
+     * XXX: support other 4:2:0 pixel formats */
+    if (inlink0->format == AV_PIX_FMT_YUV420P && scale->in_v_chr_pos == -513) {
+        scale->in_v_chr_pos = (i == 0) ? 128 : (i == 1) ? 64 : 192;
+    }
+
+    if (outlink->format == AV_PIX_FMT_YUV420P && scale->out_v_chr_pos == -513) {
+        scale->out_v_chr_pos = (i == 0) ? 128 : (i == 1) ? 64 : 192;
+    }
+
+    av_opt_set_int(*s, "src_h_chr_pos", scale->in_h_chr_pos, 0);
+    av_opt_set_int(*s, "src_v_chr_pos", scale->in_v_chr_pos, 0);
+    av_opt_set_int(*s, "dst_h_chr_pos", scale->out_h_chr_pos, 0);
+    av_opt_set_int(*s, "dst_v_chr_pos", scale->out_v_chr_pos, 0);
+
+    return sws_init_context(*s, NULL, NULL);
+}
+
 static int config_props(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
@@ -362,6 +432,7 @@ static int config_props(AVFilterLink *outlink)
         sws_freeContext(scale->isws[0]);
     if (scale->isws[1])
         sws_freeContext(scale->isws[1]);
+    free_thread_contexts(scale);
     scale->isws[0] = scale->isws[1] = scale->sws = NULL;
     if (inlink0->w == outlink->w &&
         inlink0->h == outlink->h &&
@@ -371,58 +442,29 @@ static int config_props(AVFilterLink *outlink)
         ;
     else {
         struct SwsContext **swscs[3] = {&scale->sws, &scale->isws[0], &scale->isws[1]};
-        int i;
+        int i, nb_threads;
 
         for (i = 0; i < 3; i++) {
-            struct SwsContext **s = swscs[i];
-            *s = sws_alloc_context();
-            if (!*s)
-                return AVERROR(ENOMEM);
-
-            av_opt_set_int(*s, "srcw", inlink0 ->w, 0);
-            av_opt_set_int(*s, "srch", inlink0 ->h >> !!i, 0);
-            av_opt_set_int(*s, "src_format", inlink0->format, 0);
-            av_opt_set_int(*s, "dstw", outlink->w, 0);
-            av_opt_set_int(*s, "dsth", outlink->h >> !!i, 0);
-            av_opt_set_int(*s, "dst_format", outfmt, 0);
-            av_opt_set_int(*s, "sws_flags", scale->flags, 0);
-            av_opt_set_int(*s, "param0", scale->param[0], 0);
-            av_opt_set_int(*s, "param1", scale->param[1], 0);
-            if (scale->in_range != AVCOL_RANGE_UNSPECIFIED)
-                av_opt_set_int(*s, "src_range",
-                               scale->in_range == AVCOL_RANGE_JPEG, 0);
-            if (scale->out_range != AVCOL_RANGE_UNSPECIFIED)
-                av_opt_set_int(*s, "dst_range",
-                               scale->out_range == AVCOL_RANGE_JPEG, 0);
-
-            if (scale->opts) {
-                AVDictionaryEntry *e = NULL;
-                while ((e = av_dict_get(scale->opts, "", e, AV_DICT_IGNORE_SUFFIX))) {
-                    if ((ret = av_opt_set(*s, e->key, e->value, 0)) < 0)
-                        return ret;
-                }
-            }
-            /* Override YUV420P default settings to have the correct (MPEG-2) chroma positions
-             * MPEG-2 chroma positions are used by convention
-             * XXX: support other 4:2:0 pixel formats */
-            if (inlink0->format == AV_PIX_FMT_YUV420P && scale->in_v_chr_pos == -513) {
-                scale->in_v_chr_pos = (i == 0) ? 128 : (i == 1) ? 64 : 192;
-            }
-
-            if (outlink->format == AV_PIX_FMT_YUV420P && scale->out_v_chr_pos == -513) {
-                scale->out_v_chr_pos = (i == 0) ? 128 : (i == 1) ? 64 : 192;
-            }
-
-            av_opt_set_int(*s, "src_h_chr_pos", scale->in_h_chr_pos, 0);
-            av_opt_set_int(*s, "src_v_chr_pos", scale->in_v_chr_pos, 0);
-            av_opt_set_int(*s, "dst_h_chr_pos", scale->out_h_chr_pos, 0);
-            av_opt_set_int(*s, "dst_v_chr_pos", scale->out_v_chr_pos, 0);
-
-            if ((ret = sws_init_context(*s, NULL, NULL)) < 0)
+            if ((ret = init_sws_context(ctx, swscs[i], i, inlink0, outlink, outfmt)) < 0)
                 return ret;
             if (!scale->interlaced)
                 break;
         }
+
+        nb_threads = FFMIN(ff_filter_get_nb_threads(ctx),
+                           outlink->h >> out_desc->log2_chroma_h);
+        if (nb_threads > 1 && !scale->nb_slices &&
+            sws_isSupportedDstSlice(scale->sws)) {
+            scale->tsws = av_mallocz_array(nb_threads - 1, sizeof(*scale->tsws));
+            if (!scale->tsws)
+                return AVERROR(ENOMEM);
+            for (i = 1; i < nb_threads; i++) {
+                ret = init_sws_context(ctx, &scale->tsws[scale->nb_tsws++], 0,
+                                       inlink0, outlink, outfmt);
+                if (ret < 0)
+                    return ret;
+            }
+        }
     }
 
     if (inlink->sample_aspect_ratio.num){
@@ -492,6 +534,30 @@ static int scale_slice(AVFilterLink *link, AVFrame *out_buf, AVFrame *cur_pic, s
                          out,out_stride);
 }
 
+static int scale_slice_thread(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ScaleContext *scale = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
+    ThreadData *td = arg;
+    const uint8_t *in[4];
+    uint8_t *out[4];
+    const int vsub = av_pix_fmt_desc_get(outlink->format)->log2_chroma_h;
+    const int nb_rows = AV_CEIL_RSHIFT(outlink->h, vsub);
+    const int slice_start = ((nb_rows *  jobnr     ) / nb_jobs) << vsub;
+    const int slice_end   = FFMIN(((nb_rows * (jobnr+1)) / nb_jobs) << vsub, outlink->h);
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        in[i]  = td->in->data[i];
+        out[i] = td->out->data[i];
+    }
+
+    return sws_scale_dst_slice(jobnr ? scale->tsws[jobnr - 1] : scale->sws,
+                               in, td->in->linesize,
+                               out, td->out->linesize,
+                               slice_start, slice_end - slice_start);
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
     ScaleContext *scale = link->dst->priv;
@@ -499,7 +565,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     AVFrame *out;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
     char buf[32];
-    int in_range;
+    int in_range, i;
 
     if (av_frame_get_colorspace(in) == AVCOL_SPC_YCGCO)
         av_log(link->dst, AV_LOG_WARNING, "Detected unsupported YCgCo colorspace.\n");
@@ -587,6 +653,10 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
             sws_setColorspaceDetails(scale->isws[1], inv_table, in_full,
                                      table, out_full,
                                      brightness, contrast, saturation);
+        for (i = 0; i < scale->nb_tsws; i++)
+            sws_setColorspaceDetails(scale->tsws[i], inv_table, in_full,
+                                     table, out_full,
+                                     brightness, contrast, saturation);
 
         av_frame_set_color_range(out, out_full ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG);
     }
@@ -599,6 +669,10 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     if(scale->interlaced>0 || (scale->interlaced<0 && in->interlaced_frame)){
         scale_slice(link, out, in, scale->isws[0], 0, (link->h+1)/2, 2, 0);
         scale_slice(link, out, in, scale->isws[1], 0,  link->h   /2, 2, 1);
+    }else if (scale->nb_tsws) {
+        ThreadData td = { .in = in, .out = out };
+        link->dst->internal->execute(link->dst, scale_slice_thread, &td, NULL,
+                                     scale->nb_tsws + 1);
     }else if (scale->nb_slices) {
         int i, slice_h, slice_start, slice_end = 0;
         const int nb_slices = FFMIN(scale->nb_slices, link->h);
@@ -729,6 +803,7 @@ AVFilter ff_vf_scale = {
     .inputs          = avfilter_vf_scale_inputs,
     .outputs         = avfilter_vf_scale_outputs,
     .process_command = process_command,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
 
 static const AVClass scale2ref_class = {
@@ -781,4 +856,5 @@ AVFilter ff_vf_scale2ref = {
     .inputs          = avfilter_vf_scale2ref_inputs,
     .outputs         = avfilter_vf_scale2ref_outputs,
     .process_command = process_command,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -0,0 +1,182 @@
+;*****************************************************************************
+;* x86-optimized functions for nnedi filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or modify
+;* it under the terms of the GNU General Public License as published by
+;* the Free Software Foundation; either version 2 of the License, or
+;* (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;* GNU General Public License for more details.
+;*
+;* You should have received a copy of the GNU General Public License along
+;* with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+;* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+ps_exp_lo:  times 8 dd -80.0
+ps_exp_hi:  times 8 dd  80.0
+ps_log2e:   times 8 dd 1.44269504088896341
+ps_ln2_hi:  times 8 dd -0.693359375        ; -ln(2) split in two parts
+ps_ln2_lo:  times 8 dd 2.12194440e-4
+ps_exp_p0:  times 8 dd 1.9875691500e-4
+ps_exp_p1:  times 8 dd 1.3981999507e-3
+ps_exp_p2:  times 8 dd 8.3334519073e-3
+ps_exp_p3:  times 8 dd 4.1665795894e-2
+ps_exp_p4:  times 8 dd 1.6666665459e-1
+ps_exp_p5:  times 8 dd 5.0000001201e-1
+ps_1:       times 8 dd 1.0
+pd_127:     times 8 dd 127
+
+SECTION .text
+
+%if ARCH_X86_64
+; multiply-accumulate the data at m5 with the weights of 4 neurons into m1-m4
+; %1/%2 are the data/weights load registers, xmm for the last 4 floats
+%macro DOT4 2
+    movu            %1, [dataq + offq]
+    movu            %2, [weightsq + offq]
+    FMULADD_PS      m1, m5, m6, m1, m7
+    movu            %2, [w1q + offq]
+    FMULADD_PS      m2, m5, m6, m2, m7
+    movu            %2, [w2q + offq]
+    FMULADD_PS      m3, m5, m6, m3, m7
+    movu            %2, [w3q + offq]
+    FMULADD_PS      m4, m5, m6, m4, m7
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_dot_prod(const float *data, const float *weights, float *vals,
+;                        int n, int len, float scale)
+;------------------------------------------------------------------------------
+
+%macro DOT_PROD 0
+cglobal nnedi_dot_prod, 5, 10, 8, data, weights, vals, n, len, off, w1, w2, w3, bias
+%if WIN64
+    movss           xm0, r5m
+%endif
+    shufps          xm0, xm0, 0
+    movsxdifnidn    lenq, lend
+    shl             lenq, 2
+    mov             biasd, nd
+    imul            biasq, lenq
+    add             biasq, weightsq
+    add             dataq, lenq
+    add             weightsq, lenq          ; end of the weights of neuron 0
+.loop_n:
+    lea             w1q, [weightsq + lenq]
+    lea             w2q, [weightsq + lenq * 2]
+    lea             w3q, [w1q + lenq * 2]
+    mov             offq, lenq
+    neg             offq
+    xorps           m1, m1
+    xorps           m2, m2
+    xorps           m3, m3
+    xorps           m4, m4
+%if mmsize == 32
+    cmp             offq, -mmsize
+    jg .tail
+%endif
+.loop_len:
+    DOT4            m5, m6
+    add             offq, mmsize
+%if mmsize == 32
+    cmp             offq, -mmsize
+    jle .loop_len
+.tail:
+    test            offq, offq
+    jz .sum
+    DOT4            xm5, xm6
+.sum:
+    vextractf128    xm5, m1, 1
+    vextractf128    xm6, m2, 1
+    addps           xm1, xm5
+    addps           xm2, xm6
+    vextractf128    xm5, m3, 1
+    vextractf128    xm6, m4, 1
+    addps           xm3, xm5
+    addps           xm4, xm6
+%else
+    jl .loop_len
+%endif
+    ; horizontal sums of xm1-xm4 into the 4 lanes of xm1
+    unpckhps        xm5, xm1, xm2
+    unpcklps        xm1, xm2
+    addps           xm1, xm5
+    unpckhps        xm6, xm3, xm4
+    unpcklps        xm3, xm4
+    addps           xm3, xm6
+    movhlps         xm5, xm3, xm1
+    movlhps         xm1, xm3
+    addps           xm1, xm5
+    mulps           xm1, xm0
+    movu            xm5, [biasq]
+    addps           xm1, xm5
+    movu        [valsq], xm1
+    add             valsq, 16
+    add             biasq, 16
+    lea             weightsq, [weightsq + lenq * 4]
+    sub             nd, 4
+    jg .loop_n
+    RET
+%endmacro
+
+INIT_XMM sse
+DOT_PROD
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+DOT_PROD
+%endif
+%endif ; ARCH_X86_64
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_exp(float *s, int n)
+;------------------------------------------------------------------------------
+
+%macro EXP 0
+cglobal nnedi_exp, 2, 2, 6, s, n
+    movsxdifnidn    nq, nd
+    lea             sq, [sq + nq * 4]
+    shl             nq, 2
+    neg             nq
+.loop:
+    movu            m0, [sq + nq]
+    maxps           m0, [ps_exp_lo]
+    minps           m0, [ps_exp_hi]
+    mulps           m1, m0, [ps_log2e]
+    cvtps2dq        m1, m1                  ; k = round(x / ln(2))
+    cvtdq2ps        m2, m1
+    FMULADD_PS      m0, m2, [ps_ln2_hi], m0, m3
+    FMULADD_PS      m0, m2, [ps_ln2_lo], m0, m3 ; r = x - k * ln(2)
+    mulps           m4, m0, m0
+    mova            m3, [ps_exp_p0]
+    FMULADD_PS      m3, m3, m0, [ps_exp_p1], m5
+    FMULADD_PS      m3, m3, m0, [ps_exp_p2], m5
+    FMULADD_PS      m3, m3, m0, [ps_exp_p3], m5
+    FMULADD_PS      m3, m3, m0, [ps_exp_p4], m5
+    FMULADD_PS      m3, m3, m0, [ps_exp_p5], m5
+    FMULADD_PS      m3, m3, m4, m0, m5
+    addps           m3, [ps_1]              ; exp(r)
+    paddd           m1, [pd_127]
+    pslld           m1, 23                  ; 2^k
+    mulps           m3, m1
+    movu       [sq + nq], m3
+    add             nq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+EXP
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+EXP
+%endif
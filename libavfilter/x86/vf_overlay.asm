@@ -0,0 +1,129 @@
+;*****************************************************************************
+;* x86-optimized functions for overlay filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pw_128: times 16 dw 128
+pw_255: times 16 dw 255
+pw_257: times 16 dw 257
+
+SECTION .text
+
+%macro LOAD_BW 2 ; dst, src
+%if cpuflag(avx2)
+    pmovzxbw        %1, %2
+%else
+    movh            %1, %2
+    punpcklbw       %1, m7
+%endif
+%endmacro
+
+; m0 = dst, m1 = src, m2 = alpha as words
+; m3 = pw_255, m4 = pw_128, m5 = pw_257
+%macro BLEND 0
+    pmullw          m1, m2               ; src * alpha
+    pxor            m2, m3               ; 255 - alpha
+    pmullw          m0, m2               ; dst * (255 - alpha)
+    paddw           m0, m1
+    paddw           m0, m4
+    pmulhuw         m0, m5               ; ((x + 128) * 257) >> 16
+    packuswb        m0, m0
+%endmacro
+
+%macro STORE 1
+%if cpuflag(avx2)
+    vpermq          m0, m0, q3120
+    movu            %1, xm0
+%else
+    movh            %1, m0
+%endif
+%endmacro
+
+%macro BLEND_CONSTANTS 0
+    mova            m3, [pw_255]
+    mova            m4, [pw_128]
+    mova            m5, [pw_257]
+%if notcpuflag(avx2)
+    pxor            m7, m7
+%endif
+%endmacro
+
+%macro OVERLAY_FUNCS 0
+; void ff_overlay_blend_row(uint8_t *dst, const uint8_t *src,
+;                           const uint8_t *alpha, int w)
+cglobal overlay_blend_row, 4, 4, 8, dst, src, alpha, w
+    movsxdifnidn    wq, wd
+    add           dstq, wq
+    add           srcq, wq
+    add         alphaq, wq
+    neg             wq
+    BLEND_CONSTANTS
+
+.loop:
+    LOAD_BW         m0, [dstq + wq]
+    LOAD_BW         m1, [srcq + wq]
+    LOAD_BW         m2, [alphaq + wq]
+    BLEND
+    STORE           [dstq + wq]
+    add             wq, mmsize / 2
+    jl .loop
+    RET
+
+; void ff_overlay_blend_row_420(uint8_t *dst, const uint8_t *src,
+;                               const uint8_t *alpha, ptrdiff_t alpha_linesize,
+;                               int w)
+cglobal overlay_blend_row_420, 5, 5, 8, dst, src, alpha, alpha2, w
+    movsxdifnidn    wq, wd
+    add           dstq, wq
+    add           srcq, wq
+    lea         alphaq, [alphaq + 2 * wq]
+    add        alpha2q, alphaq
+    neg             wq
+    BLEND_CONSTANTS
+
+.loop:
+    movu            m2, [alphaq  + 2 * wq]
+    movu            m6, [alpha2q + 2 * wq]
+    psrlw           m1, m2, 8            ; odd alpha samples
+    pand            m2, m3               ; even alpha samples
+    paddw           m2, m1
+    psrlw           m1, m6, 8
+    pand            m6, m3
+    paddw           m2, m6
+    paddw           m2, m1
+    psrlw           m2, 2                ; average of the 2x2 block
+    LOAD_BW         m0, [dstq + wq]
+    LOAD_BW         m1, [srcq + wq]
+    BLEND
+    STORE           [dstq + wq]
+    add             wq, mmsize / 2
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+OVERLAY_FUNCS
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+OVERLAY_FUNCS
+%endif
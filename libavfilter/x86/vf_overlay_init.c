@@ -0,0 +1,46 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/overlay.h"
+
+#define OVERLAY_FUNCS(opt)                                                      \
+void ff_overlay_blend_row_##opt(uint8_t *dst, const uint8_t *src,              \
+                                const uint8_t *alpha, int w);                  \
+void ff_overlay_blend_row_420_##opt(uint8_t *dst, const uint8_t *src,          \
+                                    const uint8_t *alpha,                      \
+                                    ptrdiff_t alpha_linesize, int w);
+
+OVERLAY_FUNCS(sse2)
+OVERLAY_FUNCS(avx2)
+
+av_cold void ff_overlay_init_x86(OverlayDSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        dsp->blend_row     = ff_overlay_blend_row_sse2;
+        dsp->blend_row_420 = ff_overlay_blend_row_420_sse2;
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        dsp->blend_row     = ff_overlay_blend_row_avx2;
+        dsp->blend_row_420 = ff_overlay_blend_row_420_avx2;
+    }
+}
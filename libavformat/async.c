@@ -30,8 +30,8 @@
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/error.h"
-#include "libavutil/fifo.h"
 #include "libavutil/log.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/thread.h"
 #include "url.h"
@@ -44,13 +44,24 @@
 #define BUFFER_CAPACITY         (4 * 1024 * 1024)
 #define READ_BACK_CAPACITY      (4 * 1024 * 1024)
 #define SHORT_SEEK_THRESHOLD    (256 * 1024)
+#define MAX_READ_SIZE           (64 * 1024)
 
+/*
+ * Bytes are stored at their stream position modulo the buffer size, so the
+ * data in [start, end) stays in place until the writer reuses its space.
+ * The reader keeps up to read_back_capacity bytes before its position for
+ * seeking back. Only the positions are protected by the mutex: the reader
+ * copies out of and the background thread reads into the buffer without
+ * holding it, as the ranges they access never overlap.
+ */
 typedef struct RingBuffer
 {
-    AVFifoBuffer *fifo;
+    uint8_t      *buf;
+    int           size;
     int           read_back_capacity;
 
-    int           read_pos;
+    int64_t       start;
+    int64_t       end;
 } RingBuffer;
 
 typedef struct Context {
@@ -63,7 +74,6 @@ typedef struct Context {
     int             seek_completed;
     int64_t         seek_ret;
 
-    int             inner_io_error;
     int             io_error;
     int             io_eof_reached;
 
@@ -78,73 +88,74 @@ typedef struct Context {
 
     int             abort_request;
     AVIOInterruptCB interrupt_callback;
+
+    int             buffer_size;
+    int             read_back_size;
 } Context;
 
 static int ring_init(RingBuffer *ring, unsigned int capacity, int read_back_capacity)
 {
     memset(ring, 0, sizeof(RingBuffer));
-    ring->fifo = av_fifo_alloc(capacity + read_back_capacity);
-    if (!ring->fifo)
+    ring->buf = av_malloc(capacity + read_back_capacity);
+    if (!ring->buf)
         return AVERROR(ENOMEM);
 
+    ring->size               = capacity + read_back_capacity;
     ring->read_back_capacity = read_back_capacity;
     return 0;
 }
 
 static void ring_destroy(RingBuffer *ring)
 {
-    av_fifo_freep(&ring->fifo);
+    av_freep(&ring->buf);
 }
 
-static void ring_reset(RingBuffer *ring)
+static void ring_reset(RingBuffer *ring, int64_t pos)
 {
-    av_fifo_reset(ring->fifo);
-    ring->read_pos = 0;
+    ring->start = ring->end = pos;
 }
 
-static int ring_size(RingBuffer *ring)
+/* number of bytes that can be read at pos */
+static int ring_size(RingBuffer *ring, int64_t pos)
 {
-    return av_fifo_size(ring->fifo) - ring->read_pos;
+    return ring->end - pos;
 }
 
 static int ring_space(RingBuffer *ring)
 {
-    return av_fifo_space(ring->fifo);
+    return ring->size - (ring->end - ring->start);
 }
 
-static int ring_generic_read(RingBuffer *ring, void *dest, int buf_size, void (*func)(void*, void*, int))
+static int ring_size_of_read_back(RingBuffer *ring, int64_t pos)
 {
-    int ret;
-
-    av_assert2(buf_size <= ring_size(ring));
-    ret = av_fifo_generic_peek_at(ring->fifo, dest, ring->read_pos, buf_size, func);
-    ring->read_pos += buf_size;
-
-    if (ring->read_pos > ring->read_back_capacity) {
-        av_fifo_drain(ring->fifo, ring->read_pos - ring->read_back_capacity);
-        ring->read_pos = ring->read_back_capacity;
-    }
-
-    return ret;
+    return pos - ring->start;
 }
 
-static int ring_generic_write(RingBuffer *ring, void *src, int size, int (*func)(void*, void*, int))
+/* copy size bytes at pos out of the buffer */
+static void ring_read(RingBuffer *ring, int64_t pos, uint8_t *dest, int size)
 {
-    av_assert2(size <= ring_space(ring));
-    return av_fifo_generic_write(ring->fifo, src, size, func);
+    int offset = pos % ring->size;
+    int len    = FFMIN(size, ring->size - offset);
+
+    av_assert2(size <= ring_size(ring, pos));
+    memcpy(dest, ring->buf + offset, len);
+    memcpy(dest + len, ring->buf, size - len);
 }
 
-static int ring_size_of_read_back(RingBuffer *ring)
+/* drop the data that is too far behind the read position pos */
+static void ring_drain(RingBuffer *ring, int64_t pos)
 {
-    return ring->read_pos;
+    if (ring_size_of_read_back(ring, pos) > ring->read_back_capacity)
+        ring->start = pos - ring->read_back_capacity;
 }
 
-static int ring_drain(RingBuffer *ring, int offset)
+/* contiguous free space at the end of the data, at most max_size bytes */
+static uint8_t *ring_write_ptr(RingBuffer *ring, int *max_size)
 {
-    av_assert2(offset >= -ring_size_of_read_back(ring));
-    av_assert2(offset <= -ring_size(ring));
-    ring->read_pos += offset;
-    return 0;
+    int offset = ring->end % ring->size;
+
+    *max_size = FFMIN3(*max_size, ring_space(ring), ring->size - offset);
+    return ring->buf + offset;
 }
 
 static int async_check_interrupt(void *arg)
@@ -161,18 +172,6 @@ static int async_check_interrupt(void *arg)
     return c->abort_request;
 }
 
-static int wrapped_url_read(void *src, void *dst, int size)
-{
-    URLContext *h   = src;
-    Context    *c   = h->priv_data;
-    int         ret;
-
-    ret = ffurl_read(c->inner, dst, size);
-    c->inner_io_error = ret < 0 ? ret : 0;
-
-    return ret;
-}
-
 static void *async_buffer_task(void *arg)
 {
     URLContext   *h    = arg;
@@ -182,7 +181,8 @@ static void *async_buffer_task(void *arg)
     int64_t       seek_ret;
 
     while (1) {
-        int fifo_space, to_copy;
+        int      to_copy = MAX_READ_SIZE;
+        uint8_t *dst;
 
         pthread_mutex_lock(&c->mutex);
         if (async_check_interrupt(h)) {
@@ -198,7 +198,7 @@ static void *async_buffer_task(void *arg)
             if (seek_ret >= 0) {
                 c->io_eof_reached = 0;
                 c->io_error       = 0;
-                ring_reset(ring);
+                ring_reset(ring, seek_ret);
             }
 
             c->seek_completed = 1;
@@ -211,8 +211,8 @@ static void *async_buffer_task(void *arg)
             continue;
         }
 
-        fifo_space = ring_space(ring);
-        if (c->io_eof_reached || fifo_space <= 0) {
+        dst = ring_write_ptr(ring, &to_copy);
+        if (c->io_eof_reached || to_copy <= 0) {
             pthread_cond_signal(&c->cond_wakeup_main);
             pthread_cond_wait(&c->cond_wakeup_background, &c->mutex);
             pthread_mutex_unlock(&c->mutex);
@@ -220,14 +220,15 @@ static void *async_buffer_task(void *arg)
         }
         pthread_mutex_unlock(&c->mutex);
 
-        to_copy = FFMIN(4096, fifo_space);
-        ret = ring_generic_write(ring, (void *)h, to_copy, wrapped_url_read);
+        ret = ffurl_read(c->inner, dst, to_copy);
 
         pthread_mutex_lock(&c->mutex);
-        if (ret <= 0) {
+        if (ret > 0) {
+            ring->end += ret;
+        } else {
             c->io_eof_reached = 1;
-            if (c->inner_io_error < 0)
-                c->io_error = c->inner_io_error;
+            if (ret < 0)
+                c->io_error = ret;
         }
 
         pthread_cond_signal(&c->cond_wakeup_main);
@@ -245,7 +246,7 @@ static int async_open(URLContext *h, const char *arg, int flags, AVDictionary **
 
     av_strstart(arg, "async:", &arg);
 
-    ret = ring_init(&c->ring, BUFFER_CAPACITY, READ_BACK_CAPACITY);
+    ret = ring_init(&c->ring, c->buffer_size, c->read_back_size);
     if (ret < 0)
         goto fifo_fail;
 
@@ -323,8 +324,8 @@ static int async_close(URLContext *h)
     return 0;
 }
 
-static int async_read_internal(URLContext *h, void *dest, int size, int read_complete,
-                               void (*func)(void*, void*, int))
+/* read into dest, or only skip the data if dest is NULL */
+static int async_read_internal(URLContext *h, uint8_t *dest, int size, int read_complete)
 {
     Context      *c       = h->priv_data;
     RingBuffer   *ring    = &c->ring;
@@ -339,15 +340,19 @@ static int async_read_internal(URLContext *h, void *dest, int size, int read_com
             ret = AVERROR_EXIT;
             break;
         }
-        fifo_size = ring_size(ring);
+        fifo_size = ring_size(ring, c->logical_pos);
         to_copy   = FFMIN(to_read, fifo_size);
         if (to_copy > 0) {
-            ring_generic_read(ring, dest, to_copy, func);
-            if (!func)
-                dest = (uint8_t *)dest + to_copy;
+            if (dest) {
+                pthread_mutex_unlock(&c->mutex);
+                ring_read(ring, c->logical_pos, dest, to_copy);
+                dest += to_copy;
+                pthread_mutex_lock(&c->mutex);
+            }
             c->logical_pos += to_copy;
             to_read        -= to_copy;
             ret             = size - to_read;
+            ring_drain(ring, c->logical_pos);
 
             if (to_read <= 0 || !read_complete)
                 break;
@@ -372,11 +377,7 @@ static int async_read_internal(URLContext *h, void *dest, int size, int read_com
 
 static int async_read(URLContext *h, unsigned char *buf, int size)
 {
-    return async_read_internal(h, buf, size, 0, NULL);
-}
-
-static void fifo_do_not_copy_func(void* dest, void* src, int size) {
-    // do not copy
+    return async_read_internal(h, buf, size, 0);
 }
 
 static int64_t async_seek(URLContext *h, int64_t pos, int whence)
@@ -403,28 +404,27 @@ static int64_t async_seek(URLContext *h, int64_t pos, int whence)
     if (new_logical_pos < 0)
         return AVERROR(EINVAL);
 
-    fifo_size = ring_size(ring);
-    fifo_size_of_read_back = ring_size_of_read_back(ring);
-    if (new_logical_pos == c->logical_pos) {
-        /* current position */
+    pthread_mutex_lock(&c->mutex);
+    fifo_size = ring_size(ring, c->logical_pos);
+    fifo_size_of_read_back = ring_size_of_read_back(ring, c->logical_pos);
+    if (new_logical_pos >= c->logical_pos - fifo_size_of_read_back &&
+        new_logical_pos <= c->logical_pos) {
+        /* current position, or fast seek backwards within the kept data */
+        c->logical_pos = new_logical_pos;
+        pthread_mutex_unlock(&c->mutex);
         return c->logical_pos;
-    } else if ((new_logical_pos >= (c->logical_pos - fifo_size_of_read_back)) &&
-               (new_logical_pos < (c->logical_pos + fifo_size + SHORT_SEEK_THRESHOLD))) {
+    }
+    pthread_mutex_unlock(&c->mutex);
+
+    if (new_logical_pos > c->logical_pos &&
+        new_logical_pos < c->logical_pos + fifo_size + SHORT_SEEK_THRESHOLD) {
         int pos_delta = (int)(new_logical_pos - c->logical_pos);
-        /* fast seek */
+        /* fast seek forwards */
         av_log(h, AV_LOG_TRACE, "async_seek: fask_seek %"PRId64" from %d dist:%d/%d\n",
                 new_logical_pos, (int)c->logical_pos,
                 (int)(new_logical_pos - c->logical_pos), fifo_size);
 
-        if (pos_delta > 0) {
-            // fast seek forwards
-            async_read_internal(h, NULL, pos_delta, 1, fifo_do_not_copy_func);
-        } else {
-            // fast seek backwards
-            ring_drain(ring, pos_delta);
-            c->logical_pos = new_logical_pos;
-        }
-
+        async_read_internal(h, NULL, pos_delta, 1);
         return c->logical_pos;
     } else if (c->logical_size <= 0) {
         /* can not seek */
@@ -466,6 +466,10 @@ static int64_t async_seek(URLContext *h, int64_t pos, int whence)
 #define D AV_OPT_FLAG_DECODING_PARAM
 
 static const AVOption options[] = {
+    { "async_buffer_size", "size of the buffer filled ahead of the read position",
+        OFFSET(buffer_size), AV_OPT_TYPE_INT, { .i64 = BUFFER_CAPACITY }, 1, INT_MAX / 2, .flags = D },
+    { "async_read_back_size", "amount of data kept behind the read position for seeking back",
+        OFFSET(read_back_size), AV_OPT_TYPE_INT, { .i64 = READ_BACK_CAPACITY }, 0, INT_MAX / 2, .flags = D },
     {NULL},
 };
 
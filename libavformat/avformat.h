@@ -1057,7 +1057,7 @@ typedef struct AVStream {
     struct AVCodecParserContext *parser;
 
     /**
-     * last packet in packet_buffer for this stream when muxing.
+     * last packet in the interleaving queue for this stream when muxing.
      */
     struct AVPacketList *last_in_packet_buffer;
     AVProbeData probe_data;
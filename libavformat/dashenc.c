@@ -38,6 +38,7 @@
 #include "internal.h"
 #include "isom.h"
 #include "os_support.h"
+#include "uploadqueue.h"
 #include "url.h"
 
 // See ISO/IEC 23009-1:2014 5.3.9.4.4
@@ -98,6 +99,11 @@ typedef struct DASHContext {
     const char *media_seg_name;
     AVRational min_frame_rate, max_frame_rate;
     int ambiguous_frame_rate;
+    const char *method;
+    int http_persistent;
+    int async_upload;
+    int64_t upload_queue_size;
+    UploadQueue *upload;
 } DASHContext;
 
 static int dash_write(void *opaque, uint8_t *buf, int buf_size)
@@ -186,7 +192,7 @@ static void dash_free(AVFormatContext *s)
             av_write_trailer(os->ctx);
         if (os->ctx && os->ctx->pb)
             av_free(os->ctx->pb);
-        ff_format_io_close(s, &os->out);
+        ff_upload_queue_close(c->upload, &os->out);
         if (os->ctx)
             avformat_free_context(os->ctx);
         for (j = 0; j < os->nb_segments; j++)
@@ -438,16 +444,34 @@ static void format_date_now(char *buf, int size)
     }
 }
 
+static void set_http_options(AVDictionary **options, DASHContext *c)
+{
+    if (c->method)
+        av_dict_set(options, "method", c->method, 0);
+}
+
+/* Files are written under a temporary name and then renamed, which is only
+ * possible with the file protocol. */
+static int use_rename(AVFormatContext *s)
+{
+    const char *proto = avio_find_protocol_name(s->filename);
+
+    return proto && !strcmp(proto, "file");
+}
+
 static int write_manifest(AVFormatContext *s, int final)
 {
     DASHContext *c = s->priv_data;
-    AVIOContext *out;
+    AVIOContext *out = NULL;
+    AVDictionary *opts = NULL;
     char temp_filename[1024];
     int ret, i;
     AVDictionaryEntry *title = av_dict_get(s->metadata, "title", NULL, 0);
 
-    snprintf(temp_filename, sizeof(temp_filename), "%s.tmp", s->filename);
-    ret = s->io_open(s, &out, temp_filename, AVIO_FLAG_WRITE, NULL);
+    snprintf(temp_filename, sizeof(temp_filename), use_rename(s) ? "%s.tmp" : "%s", s->filename);
+    set_http_options(&opts, c);
+    ret = ff_upload_queue_open(c->upload, &out, temp_filename, &opts);
+    av_dict_free(&opts);
     if (ret < 0) {
         av_log(s, AV_LOG_ERROR, "Unable to open %s for writing\n", temp_filename);
         return ret;
@@ -547,8 +571,9 @@ static int write_manifest(AVFormatContext *s, int final)
     avio_printf(out, "\t</Period>\n");
     avio_printf(out, "</MPD>\n");
     avio_flush(out);
-    ff_format_io_close(s, &out);
-    return avpriv_io_move(temp_filename, s->filename);
+    if ((ret = ff_upload_queue_close(c->upload, &out)) < 0)
+        return ret;
+    return use_rename(s) ? avpriv_io_move(temp_filename, s->filename) : 0;
 }
 
 static int dash_write_header(AVFormatContext *s)
@@ -579,6 +604,10 @@ static int dash_write_header(AVFormatContext *s)
     if (ptr)
         *ptr = '\0';
 
+    if ((ret = ff_upload_queue_alloc(&c->upload, s, c->http_persistent,
+                                     c->async_upload, c->upload_queue_size)) < 0)
+        goto fail;
+
     oformat = av_guess_format("mp4", NULL, NULL);
     if (!oformat) {
         ret = AVERROR_MUXER_NOT_FOUND;
@@ -649,7 +678,12 @@ static int dash_write_header(AVFormatContext *s)
             dash_fill_tmpl_params(os->initfile, sizeof(os->initfile), c->init_seg_name, i, 0, os->bit_rate, 0);
         }
         snprintf(filename, sizeof(filename), "%s%s", c->dirname, os->initfile);
-        ret = s->io_open(s, &os->out, filename, AVIO_FLAG_WRITE, NULL);
+        set_http_options(&opts, c);
+        if (c->single_file)
+            ret = s->io_open(s, &os->out, filename, AVIO_FLAG_WRITE, &opts);
+        else
+            ret = ff_upload_queue_open(c->upload, &os->out, filename, &opts);
+        av_dict_free(&opts);
         if (ret < 0)
             goto fail;
         os->init_start_pos = 0;
@@ -700,8 +734,10 @@ static int dash_write_header(AVFormatContext *s)
         av_log(s, AV_LOG_VERBOSE, "Manifest written to: %s\n", s->filename);
 
 fail:
-    if (ret)
+    if (ret) {
         dash_free(s);
+        ff_upload_queue_free(&c->upload);
+    }
     return ret;
 }
 
@@ -800,6 +836,7 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
     DASHContext *c = s->priv_data;
     int i, ret = 0;
     int cur_flush_segment_index = 0;
+    int tmp_file = use_rename(s);
     if (stream >= 0)
         cur_flush_segment_index = c->streams[stream].segment_index;
 
@@ -827,17 +864,20 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         if (!os->init_range_length) {
             av_write_frame(os->ctx, NULL);
             os->init_range_length = avio_tell(os->ctx->pb);
-            if (!c->single_file)
-                ff_format_io_close(s, &os->out);
+            if (!c->single_file && (ret = ff_upload_queue_close(c->upload, &os->out)) < 0)
+                break;
         }
 
         start_pos = avio_tell(os->ctx->pb);
 
         if (!c->single_file) {
+            AVDictionary *opts = NULL;
             dash_fill_tmpl_params(filename, sizeof(filename), c->media_seg_name, i, os->segment_index, os->bit_rate, os->start_pts);
             snprintf(full_path, sizeof(full_path), "%s%s", c->dirname, filename);
-            snprintf(temp_path, sizeof(temp_path), "%s.tmp", full_path);
-            ret = s->io_open(s, &os->out, temp_path, AVIO_FLAG_WRITE, NULL);
+            snprintf(temp_path, sizeof(temp_path), tmp_file ? "%s.tmp" : "%s", full_path);
+            set_http_options(&opts, c);
+            ret = ff_upload_queue_open(c->upload, &os->out, temp_path, &opts);
+            av_dict_free(&opts);
             if (ret < 0)
                 break;
             write_styp(os->ctx->pb);
@@ -853,9 +893,9 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         if (c->single_file) {
             find_index_range(s, full_path, start_pos, &index_length);
         } else {
-            ff_format_io_close(s, &os->out);
-            ret = avpriv_io_move(temp_path, full_path);
-            if (ret < 0)
+            if ((ret = ff_upload_queue_close(c->upload, &os->out)) < 0)
+                break;
+            if (tmp_file && (ret = avpriv_io_move(temp_path, full_path)) < 0)
                 break;
         }
         add_segment(os, filename, os->start_pts, os->max_pts - os->start_pts, start_pos, range_length, index_length);
@@ -993,7 +1033,7 @@ static int dash_write_trailer(AVFormatContext *s)
     }
 
     dash_free(s);
-    return 0;
+    return ff_upload_queue_free(&c->upload);
 }
 
 #define OFFSET(x) offsetof(DASHContext, x)
@@ -1009,6 +1049,10 @@ static const AVOption options[] = {
     { "single_file_name", "DASH-templated name to be used for baseURL. Implies storing all segments in one file, accessed using byte ranges", OFFSET(single_file_name), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, E },
     { "init_seg_name", "DASH-templated name to used for the initialization segment", OFFSET(init_seg_name), AV_OPT_TYPE_STRING, {.str = "init-stream$RepresentationID$.m4s"}, 0, 0, E },
     { "media_seg_name", "DASH-templated name to used for the media segments", OFFSET(media_seg_name), AV_OPT_TYPE_STRING, {.str = "chunk-stream$RepresentationID$-$Number%05d$.m4s"}, 0, 0, E },
+    { "method", "set the HTTP method", OFFSET(method), AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, E },
+    { "http_persistent", "use persistent HTTP connections", OFFSET(http_persistent), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "async_upload", "upload HTTP segments and manifests in a background thread", OFFSET(async_upload), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "upload_queue_size", "maximum size in bytes of the data waiting for async upload", OFFSET(upload_queue_size), AV_OPT_TYPE_INT64, { .i64 = 32 << 20 }, 0, INT64_MAX, E },
     { NULL },
 };
 
@@ -33,12 +33,17 @@
 #include "libavutil/opt.h"
 #include "libavutil/dict.h"
 #include "libavutil/time.h"
+#if HAVE_THREADS
+#include "libavutil/thread.h"
+#endif
 #include "avformat.h"
 #include "internal.h"
 #include "avio_internal.h"
+#include "http.h"
 #include "id3v2.h"
 
 #define INITIAL_BUFFER_SIZE 32768
+#define PREFETCH_READ_SIZE  32768
 
 #define MAX_FIELD_LEN 64
 #define MAX_CHARACTERISTICS_LEN 512
@@ -84,6 +89,21 @@ enum PlaylistType {
     PLS_TYPE_VOD
 };
 
+/*
+ * A segment downloaded ahead of time by the prefetch thread of a playlist.
+ * The demuxer consumes the data while the download is still in progress.
+ */
+struct prefetch_slot {
+    int seq_no;
+    int direct;                 /* not prefetched (encrypted), opened by the demuxer */
+    uint8_t *data;
+    unsigned int data_size;
+    int len;                    /* bytes downloaded so far */
+    int read_pos;               /* bytes consumed by the demuxer */
+    int done;
+    int error;
+};
+
 /*
  * Each playlist has its own demuxer. If it currently is active,
  * it has an open AVIOContext too, and potentially an AVPacket
@@ -94,6 +114,7 @@ struct playlist {
     AVIOContext pb;
     uint8_t* read_buffer;
     AVIOContext *input;
+    int input_read_done; /* input was read to its end and kept open for reuse */
     AVFormatContext *parent;
     int index;
     AVFormatContext *ctx;
@@ -153,6 +174,25 @@ struct playlist {
      * playlist, if any. */
     int n_init_sections;
     struct segment **init_sections;
+
+    int prefetch_reading; /* the current segment is read from the prefetch ring */
+#if HAVE_THREADS
+    /* Segment read-ahead, see prefetch_thread(). Once the thread is started,
+     * the fields below are protected by prefetch_lock, and so are changes of
+     * the segment list. */
+    int prefetch_started;            /* 1: running, -1: failed to start */
+    struct prefetch_slot *prefetch;  /* ring of HLSContext.prefetch_segments slots */
+    int prefetch_head;
+    int prefetch_count;
+    int prefetch_next_seq;           /* next segment the thread will fetch */
+    int prefetch_generation;         /* bumped when the queued segments are dropped */
+    int prefetch_fetch_generation;   /* generation of the segment being fetched */
+    int prefetch_abort;
+    AVDictionary *prefetch_opts;
+    pthread_t prefetch_thread;
+    pthread_mutex_t prefetch_lock;
+    pthread_cond_t prefetch_cond;
+#endif
 };
 
 /*
@@ -204,6 +244,8 @@ typedef struct HLSContext {
     char *http_proxy;                    ///< holds the address of the HTTP proxy server
     AVDictionary *avio_opts;
     int strict_std_compliance;
+    int http_persistent;
+    int prefetch_segments;
 } HLSContext;
 
 static int read_chomp_line(AVIOContext *s, char *buf, int maxlen)
@@ -237,11 +279,15 @@ static void free_init_section_list(struct playlist *pls)
     pls->n_init_sections = 0;
 }
 
+static void prefetch_stop(HLSContext *c, struct playlist *pls);
+static int prefetch_read(struct playlist *pls, uint8_t *buf, int buf_size);
+
 static void free_playlist_list(HLSContext *c)
 {
     int i;
     for (i = 0; i < c->n_playlists; i++) {
         struct playlist *pls = c->playlists[i];
+        prefetch_stop(c, pls);
         free_segment_list(pls);
         free_init_section_list(pls);
         av_freep(&pls->main_streams);
@@ -595,16 +641,10 @@ static void update_options(char **dest, const char *name, void *src)
         av_freep(dest);
 }
 
-static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
-                    AVDictionary *opts, AVDictionary *opts2, int *is_http)
+/* Find the protocol of a segment url and check that it may be opened. */
+static int check_url(const char *url, const char **proto)
 {
-    HLSContext *c = s->priv_data;
-    AVDictionary *tmp = NULL;
     const char *proto_name = NULL;
-    int ret;
-
-    av_dict_copy(&tmp, opts, 0);
-    av_dict_copy(&tmp, opts2, 0);
 
     if (av_strstart(url, "crypto", NULL)) {
         if (url[6] == '+' || url[6] == ':')
@@ -627,7 +667,66 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     else if (strcmp(proto_name, "file") || !strncmp(url, "file,", 5))
         return AVERROR_INVALIDDATA;
 
-    ret = s->io_open(s, pb, url, AVIO_FLAG_READ, &tmp);
+    *proto = proto_name;
+    return 0;
+}
+
+/* Send the request for url on the HTTP connection of *pb, which must have
+ * been read to its end. */
+static int open_url_keepalive(AVIOContext **pb, const char *url,
+                              AVDictionary *opts)
+{
+    URLContext *uc = ffio_geturlcontext(*pb);
+    AVDictionary *tmp = NULL;
+    int ret;
+
+    if (!CONFIG_HTTP_PROTOCOL || !uc)
+        return AVERROR(ENOSYS);
+
+    av_dict_copy(&tmp, opts, 0);
+    ret = ff_http_do_new_request2(uc, url, &tmp);
+    av_dict_free(&tmp);
+    if (ret < 0)
+        return ret;
+
+    (*pb)->eof_reached = 0;
+    (*pb)->error       = 0;
+    (*pb)->buf_ptr     = (*pb)->buf_end = (*pb)->buffer;
+    (*pb)->pos         = 0;
+    return 0;
+}
+
+/* If *pb is set, it is the input of a previous request, which is reused for
+ * this one if possible and closed otherwise. */
+static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
+                    AVDictionary *opts, AVDictionary *opts2, int *is_http)
+{
+    HLSContext *c = s->priv_data;
+    AVDictionary *tmp = NULL;
+    const char *proto_name = NULL;
+    int ret;
+
+    if ((ret = check_url(url, &proto_name)) < 0)
+        return ret;
+
+    av_dict_copy(&tmp, opts, 0);
+    av_dict_copy(&tmp, opts2, 0);
+
+    ret = AVERROR(ENOSYS);
+    if (*pb && c->http_persistent && av_strstart(proto_name, "http", NULL) &&
+        !av_strstart(url, "crypto", NULL)) {
+        ret = open_url_keepalive(pb, url, tmp);
+        if (ret == AVERROR_EXIT) {
+            ff_format_io_close(s, pb);
+            av_dict_free(&tmp);
+            return ret;
+        }
+    }
+    if (ret < 0) {
+        if (*pb)
+            ff_format_io_close(s, pb);
+        ret = s->io_open(s, pb, url, AVIO_FLAG_READ, &tmp);
+    }
     if (ret >= 0) {
         // update cookies on http response with setcookies.
         void *u = (s->flags & AVFMT_FLAG_CUSTOM_IO) ? NULL : s->pb;
@@ -867,7 +966,9 @@ static int read_from_url(struct playlist *pls, struct segment *seg,
     if (seg->size >= 0)
         buf_size = FFMIN(buf_size, seg->size - pls->cur_seg_offset);
 
-    if (mode == READ_COMPLETE) {
+    if (pls->prefetch_reading) {
+        ret = prefetch_read(pls, buf, buf_size);
+    } else if (mode == READ_COMPLETE) {
         ret = avio_read(pls->input, buf, buf_size);
         if (ret != buf_size)
             av_log(NULL, AV_LOG_ERROR, "Could not read complete segment.\n");
@@ -1077,18 +1178,25 @@ static void intercept_id3(struct playlist *pls, uint8_t *buf,
         pls->is_id3_timestamped = (pls->id3_mpegts_timestamp != AV_NOPTS_VALUE);
 }
 
+static void set_segment_options(HLSContext *c, AVDictionary **opts)
+{
+    // broker prior HTTP options that should be consistent across requests
+    av_dict_set(opts, "user-agent", c->user_agent, 0);
+    av_dict_set(opts, "cookies", c->cookies, 0);
+    av_dict_set(opts, "headers", c->headers, 0);
+    av_dict_set(opts, "http_proxy", c->http_proxy, 0);
+    av_dict_set(opts, "seekable", "0", 0);
+    if (c->http_persistent)
+        av_dict_set(opts, "multiple_requests", "1", 0);
+}
+
 static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg)
 {
     AVDictionary *opts = NULL;
     int ret;
     int is_http = 0;
 
-    // broker prior HTTP options that should be consistent across requests
-    av_dict_set(&opts, "user-agent", c->user_agent, 0);
-    av_dict_set(&opts, "cookies", c->cookies, 0);
-    av_dict_set(&opts, "headers", c->headers, 0);
-    av_dict_set(&opts, "http_proxy", c->http_proxy, 0);
-    av_dict_set(&opts, "seekable", "0", 0);
+    set_segment_options(c, &opts);
 
     if (seg->size >= 0) {
         /* try to restrict the HTTP request to the part we want
@@ -1106,7 +1214,7 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg)
         AVDictionary *opts2 = NULL;
         char iv[33], key[33], url[MAX_URL_SIZE];
         if (strcmp(seg->key, pls->key_url)) {
-            AVIOContext *pb;
+            AVIOContext *pb = NULL;
             if (open_url(pls->parent, &pb, seg->key, c->avio_opts, opts, NULL) == 0) {
                 ret = avio_read(pb, pls->key, sizeof(pls->key));
                 if (ret != sizeof(pls->key)) {
@@ -1170,9 +1278,19 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg)
 cleanup:
     av_dict_free(&opts);
     pls->cur_seg_offset = 0;
+    if (!ret)
+        pls->input_read_done = 0;
     return ret;
 }
 
+/* Whether the input of a segment may be kept open to request the next one
+ * on the same connection. */
+static int keep_input_open(HLSContext *c, struct segment *seg)
+{
+    return c->http_persistent && seg->key_type == KEY_NONE &&
+           av_strstart(seg->url, "http", NULL);
+}
+
 static int update_init_section(struct playlist *pls, struct segment *seg)
 {
     static const int max_init_section_size = 1024*1024;
@@ -1214,7 +1332,10 @@ static int update_init_section(struct playlist *pls, struct segment *seg)
 
     ret = read_from_url(pls, seg->init_section, pls->init_sec_buf,
                         pls->init_sec_buf_size, READ_COMPLETE);
-    ff_format_io_close(pls->parent, &pls->input);
+    if (ret >= 0 && keep_input_open(c, seg->init_section))
+        pls->input_read_done = 1;
+    else
+        ff_format_io_close(pls->parent, &pls->input);
 
     if (ret < 0)
         return ret;
@@ -1230,6 +1351,369 @@ static int update_init_section(struct playlist *pls, struct segment *seg)
     return 0;
 }
 
+#if HAVE_THREADS
+static int prefetch_interrupt(void *opaque)
+{
+    struct playlist *pls = opaque;
+
+    return pls->prefetch_abort ||
+           pls->prefetch_fetch_generation != pls->prefetch_generation ||
+           ff_check_interrupt(&pls->parent->interrupt_callback);
+}
+
+static int prefetch_open(struct playlist *pls, AVIOContext **in, const char *url,
+                         int64_t url_offset, int64_t size)
+{
+    AVFormatContext *s = pls->parent;
+    HLSContext *c = s->priv_data;
+    AVIOInterruptCB interrupt_callback = { prefetch_interrupt, pls };
+    AVDictionary *opts = NULL;
+    const char *proto_name;
+    int is_http, ret;
+
+    if ((ret = check_url(url, &proto_name)) < 0)
+        return ret;
+    is_http = av_strstart(proto_name, "http", NULL);
+
+    av_dict_copy(&opts, pls->prefetch_opts, 0);
+    if (size >= 0) {
+        av_dict_set_int(&opts, "offset", url_offset, 0);
+        av_dict_set_int(&opts, "end_offset", url_offset + size, 0);
+    }
+
+    ret = AVERROR(ENOSYS);
+    if (*in && is_http && c->http_persistent)
+        ret = open_url_keepalive(in, url, opts);
+    if (ret < 0) {
+        avio_closep(in);
+        ret = ffio_open_whitelist(in, url, AVIO_FLAG_READ, &interrupt_callback,
+                                  &opts, s->protocol_whitelist,
+                                  s->protocol_blacklist);
+        if (ret >= 0 && !is_http && url_offset) {
+            int64_t pos = avio_seek(*in, url_offset, SEEK_SET);
+            if (pos < 0) {
+                ret = pos;
+                avio_closep(in);
+            }
+        }
+    }
+
+    av_dict_free(&opts);
+    return ret;
+}
+
+/* Download a segment into its slot. Returns AVERROR_EOF once it is complete. */
+static int prefetch_fetch(struct playlist *pls, AVIOContext **in,
+                          struct prefetch_slot *slot, const char *url,
+                          int64_t url_offset, int64_t size, uint8_t *buf)
+{
+    int generation = pls->prefetch_fetch_generation;
+    int ret;
+
+    ret = prefetch_open(pls, in, url, url_offset, size);
+    while (ret >= 0) {
+        int len = PREFETCH_READ_SIZE;
+
+        if (size >= 0) {
+            if (!size) {
+                ret = AVERROR_EOF;
+                break;
+            }
+            len = FFMIN(len, size);
+        }
+        len = avio_read(*in, buf, len);
+        if (len <= 0) {
+            ret = len ? len : AVERROR_EOF;
+            break;
+        }
+        if (size >= 0)
+            size -= len;
+
+        pthread_mutex_lock(&pls->prefetch_lock);
+        if (generation != pls->prefetch_generation) {
+            ret = AVERROR_EXIT;
+        } else if (slot->len > INT_MAX - len) {
+            ret = AVERROR(ENOMEM);
+        } else {
+            uint8_t *data = av_fast_realloc(slot->data, &slot->data_size,
+                                            slot->len + len);
+            if (data) {
+                slot->data = data;
+                memcpy(slot->data + slot->len, buf, len);
+                slot->len += len;
+                pthread_cond_broadcast(&pls->prefetch_cond);
+            } else {
+                ret = AVERROR(ENOMEM);
+            }
+        }
+        pthread_mutex_unlock(&pls->prefetch_lock);
+    }
+    return ret;
+}
+
+/*
+ * Downloads the segments following the one being demuxed, up to
+ * prefetch_segments of them, on a connection of its own. Encrypted segments
+ * are only queued as direct slots and opened by the demuxer as before.
+ */
+static void *prefetch_thread(void *arg)
+{
+    struct playlist *pls = arg;
+    HLSContext *c = pls->parent->priv_data;
+    AVIOContext *in = NULL;
+    uint8_t *buf = av_malloc(PREFETCH_READ_SIZE);
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    while (!pls->prefetch_abort) {
+        int seq_no = pls->prefetch_next_seq;
+        char url[MAX_URL_SIZE];
+        struct prefetch_slot *slot;
+        struct segment *seg;
+        int64_t url_offset, size;
+        int ret;
+
+        if (pls->prefetch_count == c->prefetch_segments ||
+            seq_no <  pls->start_seq_no ||
+            seq_no >= pls->start_seq_no + pls->n_segments) {
+            pthread_cond_wait(&pls->prefetch_cond, &pls->prefetch_lock);
+            continue;
+        }
+
+        seg  = pls->segments[seq_no - pls->start_seq_no];
+        slot = &pls->prefetch[(pls->prefetch_head + pls->prefetch_count) %
+                              c->prefetch_segments];
+        slot->seq_no   = seq_no;
+        slot->direct   = seg->key_type != KEY_NONE;
+        slot->len      = 0;
+        slot->read_pos = 0;
+        slot->done     = slot->direct || !buf;
+        slot->error    = buf ? 0 : AVERROR(ENOMEM);
+        pls->prefetch_count++;
+        pls->prefetch_next_seq++;
+        pthread_cond_broadcast(&pls->prefetch_cond);
+        if (slot->done)
+            continue;
+
+        av_strlcpy(url, seg->url, sizeof(url));
+        url_offset = seg->url_offset;
+        size       = seg->size;
+        pls->prefetch_fetch_generation = pls->prefetch_generation;
+        pthread_mutex_unlock(&pls->prefetch_lock);
+
+        av_log(pls->parent, AV_LOG_VERBOSE,
+               "HLS prefetch of segment %d, url '%s', playlist %d\n",
+               seq_no, url, pls->index);
+        ret = prefetch_fetch(pls, &in, slot, url, url_offset, size, buf);
+        if (ret != AVERROR_EOF || !c->http_persistent)
+            avio_closep(&in);
+
+        pthread_mutex_lock(&pls->prefetch_lock);
+        if (pls->prefetch_fetch_generation == pls->prefetch_generation) {
+            slot->done  = 1;
+            slot->error = ret == AVERROR_EOF ? 0 : ret;
+            pthread_cond_broadcast(&pls->prefetch_cond);
+        }
+    }
+    pthread_mutex_unlock(&pls->prefetch_lock);
+
+    avio_closep(&in);
+    av_free(buf);
+    return NULL;
+}
+
+static int prefetch_start(HLSContext *c, struct playlist *pls)
+{
+    int ret;
+
+    pls->prefetch = av_mallocz_array(c->prefetch_segments, sizeof(*pls->prefetch));
+    if (!pls->prefetch)
+        return AVERROR(ENOMEM);
+
+    av_dict_copy(&pls->prefetch_opts, c->avio_opts, 0);
+    set_segment_options(c, &pls->prefetch_opts);
+    pls->prefetch_head     = 0;
+    pls->prefetch_count    = 0;
+    pls->prefetch_next_seq = pls->cur_seq_no;
+    pls->prefetch_abort    = 0;
+
+    if ((ret = pthread_mutex_init(&pls->prefetch_lock, NULL))) {
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    if ((ret = pthread_cond_init(&pls->prefetch_cond, NULL))) {
+        pthread_mutex_destroy(&pls->prefetch_lock);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    if ((ret = pthread_create(&pls->prefetch_thread, NULL, prefetch_thread, pls))) {
+        pthread_cond_destroy(&pls->prefetch_cond);
+        pthread_mutex_destroy(&pls->prefetch_lock);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+
+    pls->prefetch_started = 1;
+    return 0;
+fail:
+    av_freep(&pls->prefetch);
+    av_dict_free(&pls->prefetch_opts);
+    return ret;
+}
+
+static void prefetch_stop(HLSContext *c, struct playlist *pls)
+{
+    int i;
+
+    if (pls->prefetch_started > 0) {
+        pthread_mutex_lock(&pls->prefetch_lock);
+        pls->prefetch_abort = 1;
+        pthread_cond_broadcast(&pls->prefetch_cond);
+        pthread_mutex_unlock(&pls->prefetch_lock);
+
+        pthread_join(pls->prefetch_thread, NULL);
+        pthread_cond_destroy(&pls->prefetch_cond);
+        pthread_mutex_destroy(&pls->prefetch_lock);
+        pls->prefetch_started = 0;
+    }
+
+    if (pls->prefetch)
+        for (i = 0; i < c->prefetch_segments; i++)
+            av_freep(&pls->prefetch[i].data);
+    av_freep(&pls->prefetch);
+    av_dict_free(&pls->prefetch_opts);
+}
+
+/* Drop all queued segments, called with prefetch_lock held. */
+static void prefetch_flush(struct playlist *pls, int next_seq)
+{
+    pls->prefetch_generation++;
+    pls->prefetch_head     = 0;
+    pls->prefetch_count    = 0;
+    pls->prefetch_next_seq = next_seq;
+    pls->prefetch_reading  = 0;
+    pthread_cond_broadcast(&pls->prefetch_cond);
+}
+
+/*
+ * Start reading the current segment from the prefetch ring. Returns
+ * AVERROR(ENOSYS) if the segment has to be opened directly instead.
+ */
+static int prefetch_open_segment(HLSContext *c, struct playlist *pls)
+{
+    struct prefetch_slot *slot;
+    int ret;
+
+    if (!c->prefetch_segments || pls->prefetch_started < 0)
+        return AVERROR(ENOSYS);
+    if (!pls->prefetch_started && (ret = prefetch_start(c, pls)) < 0) {
+        av_log(pls->parent, AV_LOG_WARNING,
+               "Could not start prefetching segments of playlist %d: %s\n",
+               pls->index, av_err2str(ret));
+        pls->prefetch_started = -1;
+        return AVERROR(ENOSYS);
+    }
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    /* the queue does not continue at the current segment after a seek, or
+     * when segments expired from a live playlist */
+    if (pls->prefetch_count ? pls->prefetch[pls->prefetch_head].seq_no != pls->cur_seq_no
+                            : pls->prefetch_next_seq != pls->cur_seq_no)
+        prefetch_flush(pls, pls->cur_seq_no);
+    while (!pls->prefetch_count)
+        pthread_cond_wait(&pls->prefetch_cond, &pls->prefetch_lock);
+
+    slot = &pls->prefetch[pls->prefetch_head];
+    if (slot->direct) {
+        pls->prefetch_head = (pls->prefetch_head + 1) % c->prefetch_segments;
+        pls->prefetch_count--;
+        pthread_cond_broadcast(&pls->prefetch_cond);
+        ret = AVERROR(ENOSYS);
+    } else {
+        pls->prefetch_reading = 1;
+        pls->cur_seg_offset   = 0;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&pls->prefetch_lock);
+    return ret;
+}
+
+static int prefetch_read(struct playlist *pls, uint8_t *buf, int buf_size)
+{
+    struct prefetch_slot *slot;
+    int ret;
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    slot = &pls->prefetch[pls->prefetch_head];
+    while (slot->read_pos == slot->len && !slot->done)
+        pthread_cond_wait(&pls->prefetch_cond, &pls->prefetch_lock);
+
+    if (slot->read_pos < slot->len) {
+        ret = FFMIN(buf_size, slot->len - slot->read_pos);
+        memcpy(buf, slot->data + slot->read_pos, ret);
+        slot->read_pos += ret;
+    } else {
+        ret = slot->error ? slot->error : AVERROR_EOF;
+    }
+    pthread_mutex_unlock(&pls->prefetch_lock);
+    return ret;
+}
+
+static void prefetch_release(struct playlist *pls)
+{
+    HLSContext *c = pls->parent->priv_data;
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    if (pls->prefetch_count) {
+        pls->prefetch_head = (pls->prefetch_head + 1) % c->prefetch_segments;
+        pls->prefetch_count--;
+    }
+    pls->prefetch_reading = 0;
+    pthread_cond_broadcast(&pls->prefetch_cond);
+    pthread_mutex_unlock(&pls->prefetch_lock);
+}
+
+/* Drop the read-ahead after a seek or when the playlist is no longer used. */
+static void prefetch_reset(struct playlist *pls)
+{
+    if (pls->prefetch_started <= 0)
+        return;
+    pthread_mutex_lock(&pls->prefetch_lock);
+    prefetch_flush(pls, -1);
+    pthread_mutex_unlock(&pls->prefetch_lock);
+}
+
+/* Playlist reloads change the segment list the prefetch thread reads. */
+static void prefetch_lock(struct playlist *pls)
+{
+    if (pls->prefetch_started > 0)
+        pthread_mutex_lock(&pls->prefetch_lock);
+}
+
+static void prefetch_unlock(struct playlist *pls)
+{
+    if (pls->prefetch_started > 0) {
+        pthread_cond_broadcast(&pls->prefetch_cond);
+        pthread_mutex_unlock(&pls->prefetch_lock);
+    }
+}
+#else
+static int prefetch_open_segment(HLSContext *c, struct playlist *pls)
+{
+    return AVERROR(ENOSYS);
+}
+
+static int prefetch_read(struct playlist *pls, uint8_t *buf, int buf_size)
+{
+    return AVERROR_BUG;
+}
+
+static void prefetch_release(struct playlist *pls) {}
+static void prefetch_reset(struct playlist *pls) {}
+static void prefetch_stop(HLSContext *c, struct playlist *pls) {}
+static void prefetch_lock(struct playlist *pls) {}
+static void prefetch_unlock(struct playlist *pls) {}
+#endif /* HAVE_THREADS */
+
 static int64_t default_reload_interval(struct playlist *pls)
 {
     return pls->n_segments > 0 ?
@@ -1248,7 +1732,7 @@ restart:
     if (!v->needed)
         return AVERROR_EOF;
 
-    if (!v->input) {
+    if ((!v->input || v->input_read_done) && !v->prefetch_reading) {
         int64_t reload_interval;
         struct segment *seg;
 
@@ -1266,6 +1750,7 @@ restart:
         if (!v->needed) {
             av_log(v->parent, AV_LOG_INFO, "No longer receiving playlist %d\n",
                 v->index);
+            prefetch_reset(v);
             return AVERROR_EOF;
         }
 
@@ -1276,7 +1761,10 @@ restart:
 reload:
         if (!v->finished &&
             av_gettime_relative() - v->last_load_time >= reload_interval) {
-            if ((ret = parse_playlist(c, v->url, v, NULL)) < 0) {
+            prefetch_lock(v);
+            ret = parse_playlist(c, v->url, v, NULL);
+            prefetch_unlock(v);
+            if (ret < 0) {
                 av_log(v->parent, AV_LOG_WARNING, "Failed to reload playlist %d\n",
                        v->index);
                 return ret;
@@ -1311,7 +1799,9 @@ reload:
         if (ret)
             return ret;
 
-        ret = open_input(c, v, seg);
+        ret = prefetch_open_segment(c, v);
+        if (ret == AVERROR(ENOSYS))
+            ret = open_input(c, v, seg);
         if (ret < 0) {
             if (ff_check_interrupt(c->interrupt_callback))
                 return AVERROR_EXIT;
@@ -1341,7 +1831,12 @@ reload:
 
         return ret;
     }
-    ff_format_io_close(v->parent, &v->input);
+    if (v->prefetch_reading)
+        prefetch_release(v);
+    else if (keep_input_open(c, current_segment(v)))
+        v->input_read_done = 1;
+    else
+        ff_format_io_close(v->parent, &v->input);
     v->cur_seq_no++;
 
     c->cur_seq_no = v->cur_seq_no;
@@ -1592,6 +2087,11 @@ static int hls_read_header(AVFormatContext *s)
     c->first_timestamp = AV_NOPTS_VALUE;
     c->cur_timestamp = AV_NOPTS_VALUE;
 
+    if (!HAVE_THREADS && c->prefetch_segments) {
+        av_log(s, AV_LOG_WARNING, "Segment prefetching requires threads, disabling it\n");
+        c->prefetch_segments = 0;
+    }
+
     if (u) {
         // get the previous user agent & set back to null if string size is zero
         update_options(&c->user_agent, "user-agent", u);
@@ -1816,6 +2316,7 @@ static int recheck_discard_flags(AVFormatContext *s, int first)
         } else if (first && !pls->cur_needed && pls->needed) {
             if (pls->input)
                 ff_format_io_close(pls->parent, &pls->input);
+            prefetch_reset(pls);
             pls->needed = 0;
             changed = 1;
             av_log(s, AV_LOG_INFO, "No longer receiving playlist %d\n", i);
@@ -2048,6 +2549,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
         struct playlist *pls = c->playlists[i];
         if (pls->input)
             ff_format_io_close(pls->parent, &pls->input);
+        prefetch_reset(pls);
         av_packet_unref(&pls->pkt);
         reset_packet(&pls->pkt);
         pls->pb.eof_reached = 0;
@@ -2096,6 +2598,10 @@ static int hls_probe(AVProbeData *p)
 static const AVOption hls_options[] = {
     {"live_start_index", "segment index to start live streams at (negative values are from the end)",
         OFFSET(live_start_index), AV_OPT_TYPE_INT, {.i64 = -3}, INT_MIN, INT_MAX, FLAGS},
+    {"http_persistent", "use persistent HTTP connections for segments",
+        OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, FLAGS},
+    {"prefetch_segments", "number of segments to download ahead per playlist, 0 to disable",
+        OFFSET(prefetch_segments), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, FLAGS},
     {NULL}
 };
 
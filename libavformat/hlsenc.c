@@ -38,6 +38,7 @@
 #include "avio_internal.h"
 #include "internal.h"
 #include "os_support.h"
+#include "uploadqueue.h"
 
 #define KEYSIZE 16
 #define LINE_BUFFER_SIZE 1024
@@ -127,6 +128,10 @@ typedef struct HLSContext {
     AVDictionary *vtt_format_options;
 
     char *method;
+    int http_persistent;
+    int async_upload;
+    int64_t upload_queue_size;
+    UploadQueue *upload;
 
 } HLSContext;
 
@@ -469,7 +474,7 @@ static int hls_window(AVFormatContext *s, int last)
     HLSContext *hls = s->priv_data;
     HLSSegment *en;
     int target_duration = 0;
-    int ret = 0;
+    int ret = 0, err;
     AVIOContext *out = NULL;
     AVIOContext *sub_out = NULL;
     char temp_filename[1024];
@@ -487,7 +492,7 @@ static int hls_window(AVFormatContext *s, int last)
 
     set_http_options(&options, hls);
     snprintf(temp_filename, sizeof(temp_filename), use_rename ? "%s.tmp" : "%s", s->filename);
-    if ((ret = s->io_open(s, &out, temp_filename, AVIO_FLAG_WRITE, &options)) < 0)
+    if ((ret = ff_upload_queue_open(hls->upload, &out, temp_filename, &options)) < 0)
         goto fail;
 
     for (en = hls->segments; en; en = en->next) {
@@ -542,7 +547,7 @@ static int hls_window(AVFormatContext *s, int last)
         avio_printf(out, "#EXT-X-ENDLIST\n");
 
     if( hls->vtt_m3u8_name ) {
-        if ((ret = s->io_open(s, &sub_out, hls->vtt_m3u8_name, AVIO_FLAG_WRITE, &options)) < 0)
+        if ((ret = ff_upload_queue_open(hls->upload, &sub_out, hls->vtt_m3u8_name, &options)) < 0)
             goto fail;
         avio_printf(sub_out, "#EXTM3U\n");
         avio_printf(sub_out, "#EXT-X-VERSION:%d\n", version);
@@ -572,8 +577,12 @@ static int hls_window(AVFormatContext *s, int last)
 
 fail:
     av_dict_free(&options);
-    ff_format_io_close(s, &out);
-    ff_format_io_close(s, &sub_out);
+    err = ff_upload_queue_close(hls->upload, &out);
+    if (ret >= 0)
+        ret = err;
+    err = ff_upload_queue_close(hls->upload, &sub_out);
+    if (ret >= 0)
+        ret = err;
     if (ret >= 0 && use_rename)
         ff_rename(temp_filename, s->filename, s);
     return ret;
@@ -660,12 +669,20 @@ static int hls_start(AVFormatContext *s)
         av_dict_free(&options);
         if (err < 0)
             return err;
-    } else
+    } else if (c->flags & HLS_SINGLE_FILE) {
         if ((err = s->io_open(s, &oc->pb, oc->filename, AVIO_FLAG_WRITE, &options)) < 0)
             goto fail;
+    } else {
+        if ((err = ff_upload_queue_open(c->upload, &oc->pb, oc->filename, &options)) < 0)
+            goto fail;
+    }
     if (c->vtt_basename) {
         set_http_options(&options, c);
-        if ((err = s->io_open(s, &vtt_oc->pb, vtt_oc->filename, AVIO_FLAG_WRITE, &options)) < 0)
+        if (c->flags & HLS_SINGLE_FILE)
+            err = s->io_open(s, &vtt_oc->pb, vtt_oc->filename, AVIO_FLAG_WRITE, &options);
+        else
+            err = ff_upload_queue_open(c->upload, &vtt_oc->pb, vtt_oc->filename, &options);
+        if (err < 0)
             goto fail;
     }
     av_dict_free(&options);
@@ -810,6 +827,10 @@ static int hls_write_header(AVFormatContext *s)
     if ((ret = hls_mux_init(s)) < 0)
         goto fail;
 
+    if ((ret = ff_upload_queue_alloc(&hls->upload, s, hls->http_persistent,
+                                     hls->async_upload, hls->upload_queue_size)) < 0)
+        goto fail;
+
     if (hls->flags & HLS_APPEND_LIST) {
         parse_playlist(s, s->filename);
     }
@@ -849,7 +870,7 @@ fail:
             avformat_free_context(hls->avf);
         if (hls->vtt_avf)
             avformat_free_context(hls->vtt_avf);
-
+        ff_upload_queue_free(&hls->upload);
     }
     return ret;
 }
@@ -916,11 +937,15 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
                 av_opt_set(hls->avf->priv_data, "mpegts_flags", "resend_headers", 0);
             hls->number++;
         } else {
-            ff_format_io_close(s, &oc->pb);
-            if (hls->vtt_avf)
-                ff_format_io_close(s, &hls->vtt_avf->pb);
+            ret = ff_upload_queue_close(hls->upload, &oc->pb);
+            if (hls->vtt_avf) {
+                int err = ff_upload_queue_close(hls->upload, &hls->vtt_avf->pb);
+                if (ret >= 0)
+                    ret = err;
+            }
 
-            ret = hls_start(s);
+            if (ret >= 0)
+                ret = hls_start(s);
         }
 
         if (ret < 0)
@@ -949,7 +974,7 @@ static int hls_write_trailer(struct AVFormatContext *s)
     av_write_trailer(oc);
     if (oc->pb) {
         hls->size = avio_tell(hls->avf->pb) - hls->start_pos;
-        ff_format_io_close(s, &oc->pb);
+        ff_upload_queue_close(hls->upload, &oc->pb);
         hls_append_segment(s, hls, hls->duration, hls->start_pos, hls->size);
     }
 
@@ -957,7 +982,7 @@ static int hls_write_trailer(struct AVFormatContext *s)
         if (vtt_oc->pb)
             av_write_trailer(vtt_oc);
         hls->size = avio_tell(hls->vtt_avf->pb) - hls->start_pos;
-        ff_format_io_close(s, &vtt_oc->pb);
+        ff_upload_queue_close(hls->upload, &vtt_oc->pb);
     }
     av_freep(&hls->basename);
     avformat_free_context(oc);
@@ -973,7 +998,7 @@ static int hls_write_trailer(struct AVFormatContext *s)
 
     hls_free_segments(hls->segments);
     hls_free_segments(hls->old_segments);
-    return 0;
+    return ff_upload_queue_free(&hls->upload);
 }
 
 #define OFFSET(x) offsetof(HLSContext, x)
@@ -1005,6 +1030,9 @@ static const AVOption options[] = {
     {"event", "EVENT playlist", 0, AV_OPT_TYPE_CONST, {.i64 = PLAYLIST_TYPE_EVENT }, INT_MIN, INT_MAX, E, "pl_type" },
     {"vod", "VOD playlist", 0, AV_OPT_TYPE_CONST, {.i64 = PLAYLIST_TYPE_VOD }, INT_MIN, INT_MAX, E, "pl_type" },
     {"method", "set the HTTP method", OFFSET(method), AV_OPT_TYPE_STRING, {.str = NULL},  0, 0,    E},
+    {"http_persistent", "use persistent HTTP connections", OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
+    {"async_upload", "upload HTTP segments and playlists in a background thread", OFFSET(async_upload), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
+    {"upload_queue_size", "maximum size in bytes of the data waiting for async upload", OFFSET(upload_queue_size), AV_OPT_TYPE_INT64, {.i64 = 32 << 20 }, 0, INT64_MAX, E },
 
     { NULL },
 };
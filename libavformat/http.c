@@ -63,6 +63,8 @@ typedef struct HTTPContext {
     int http_code;
     /* Used if "Transfer-Encoding: chunked" otherwise -1. */
     int64_t chunksize;
+    /* Set once the last chunk and its terminating line have been read. */
+    int chunkend;
     int64_t off, end_off, filesize;
     char *location;
     HTTPAuthState auth_state;
@@ -309,6 +311,105 @@ int ff_http_do_new_request(URLContext *h, const char *uri)
     return ret;
 }
 
+/* Whether the reply to the previous request has been read completely, so
+ * that the next reply starts at the current position of the connection. */
+static int http_reply_consumed(HTTPContext *s)
+{
+    int64_t target_end = s->end_off ? s->end_off : s->filesize;
+
+    if (s->buf_ptr != s->buf_end)
+        return 0;
+    if (s->chunksize >= 0)
+        return s->chunkend;
+    return target_end >= 0 && s->off >= target_end;
+}
+
+static int http_shutdown(URLContext *h, int flags);
+static int http_read_stream(URLContext *h, uint8_t *buf, int size);
+
+/* Send the end of a chunked upload if not done yet and read the reply to
+ * it, so that the connection can carry another request. */
+static int http_finish_upload(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+    uint8_t buf[1024];
+    int ret;
+
+    if (!s->chunked_post)
+        return AVERROR(EINVAL);
+    if (!s->end_chunked_post && (ret = http_shutdown(h, h->flags)) < 0)
+        return ret;
+
+    if (!s->end_header) {
+        int new_location;
+        if ((ret = http_read_header(h, &new_location)) < 0)
+            return ret;
+    }
+    if (s->http_code >= 400)
+        av_log(h, AV_LOG_WARNING, "Upload to %s failed with HTTP error %d\n",
+               s->location, s->http_code);
+    /* a reply body ending only with the connection cannot be skipped */
+    if (s->chunksize < 0 && s->filesize < 0 && s->http_code != 204)
+        return AVERROR(EINVAL);
+    while ((ret = http_read_stream(h, buf, sizeof(buf))) > 0)
+        ;
+    return ret == AVERROR_EOF ? 0 : ret;
+}
+
+int ff_http_do_new_request2(URLContext *h, const char *uri, AVDictionary **opts)
+{
+    HTTPContext *s = h->priv_data;
+    AVDictionary *options = NULL;
+    char hostname1[1024], hostname2[1024], proto1[10], proto2[10];
+    int port1, port2;
+    int ret;
+
+    if (!h->prot ||
+        !(!strcmp(h->prot->name, "http") || !strcmp(h->prot->name, "https")))
+        return AVERROR(EINVAL);
+
+    av_url_split(proto1, sizeof(proto1), NULL, 0,
+                 hostname1, sizeof(hostname1), &port1,
+                 NULL, 0, s->location);
+    av_url_split(proto2, sizeof(proto2), NULL, 0,
+                 hostname2, sizeof(hostname2), &port2,
+                 NULL, 0, uri);
+    if (strcmp(proto1, proto2) || port1 != port2 || strcmp(hostname1, hostname2)) {
+        av_log(h, AV_LOG_DEBUG, "Cannot reuse the connection to %s:%d for %s:%d\n",
+               hostname1, port1, hostname2, port2);
+        return AVERROR(EINVAL);
+    }
+
+    if (!s->hd || !s->multiple_requests)
+        return AVERROR(EINVAL);
+    if ((h->flags & AVIO_FLAG_WRITE) && (ret = http_finish_upload(h)) < 0)
+        return ret;
+    if (s->http_code == 204)
+        s->filesize = 0;
+    if (s->willclose || !http_reply_consumed(s))
+        return AVERROR(EINVAL);
+#if CONFIG_ZLIB
+    if (s->compressed)
+        return AVERROR(EINVAL);
+#endif
+
+    s->off           = 0;
+    s->end_off       = 0;
+    s->icy_data_read = 0;
+    if (opts && (ret = av_opt_set_dict(s, opts)) < 0)
+        return ret;
+
+    av_free(s->location);
+    s->location = av_strdup(uri);
+    if (!s->location)
+        return AVERROR(ENOMEM);
+
+    av_log(h, AV_LOG_DEBUG, "Reusing the connection for '%s'\n", uri);
+    ret = http_open_cnx(h, &options);
+    av_dict_free(&options);
+    return ret;
+}
+
 int ff_http_averror(int status_code, int default_averror)
 {
     switch (status_code) {
@@ -1126,6 +1227,7 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
     s->icy_data_read    = 0;
     s->filesize         = -1;
     s->willclose        = 0;
+    s->chunkend         = 0;
     s->end_chunked_post = 0;
     s->end_header       = 0;
     if (post && !s->post_data && !send_expect_100) {
@@ -1237,6 +1339,8 @@ static int http_read_stream(URLContext *h, uint8_t *buf, int size)
     }
 
     if (s->chunksize >= 0) {
+        if (s->chunkend)
+            return AVERROR_EOF;
         if (!s->chunksize) {
             char line[32];
 
@@ -1250,8 +1354,16 @@ static int http_read_stream(URLContext *h, uint8_t *buf, int size)
                 av_log(NULL, AV_LOG_TRACE, "Chunked encoding data size: %"PRId64"'\n",
                         s->chunksize);
 
-                if (!s->chunksize)
+                if (!s->chunksize) {
+                    /* consume the line ending the chunked body, so that a
+                     * persistent connection is ready for the next reply */
+                    if (s->multiple_requests) {
+                        if ((err = http_get_line(s, line, sizeof(line))) < 0)
+                            return err;
+                        s->chunkend = 1;
+                    }
                     return 0;
+                }
         }
         size = FFMIN(size, s->chunksize);
     }
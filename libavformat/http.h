@@ -47,6 +47,22 @@ void ff_http_init_auth_state(URLContext *dest, const URLContext *src);
  */
 int ff_http_do_new_request(URLContext *h, const char *uri);
 
+/**
+ * Send a new HTTP request on the connection of a previous one, if that is
+ * possible: the connection must have been opened with multiple_requests,
+ * be to the same host and the previous reply must have been read fully.
+ * For uploads, the end of the previous chunked body is sent if needed and
+ * its reply is read first.
+ *
+ * @param h pointer to the resource
+ * @param uri uri used to perform the request
+ * @param opts HTTP options to apply before the request, e.g. offset and
+ *             end_offset; may be NULL
+ * @return a negative value if the connection cannot be reused or the
+ * request failed, 0 otherwise
+ */
+int ff_http_do_new_request2(URLContext *h, const char *uri, AVDictionary **opts);
+
 int ff_http_averror(int status_code, int default_averror);
 
 #endif /* AVFORMAT_HTTP_H */
@@ -70,6 +70,34 @@ struct AVFormatInternal {
      */
     int nb_interleaved_streams;
 
+    /**
+     * Streams with packets in the interleaving queue, as a binary min-heap
+     * of stream indices ordered by their first queued packet.
+     * Muxing only.
+     */
+    int *interleave_heap;
+    int nb_interleave_heap;
+    int interleave_heap_size;
+    int (*interleave_compare)(AVFormatContext *, AVPacket *, AVPacket *);
+    /**
+     * Counter ordering the packets that continue a chunk.
+     */
+    int64_t interleave_seq;
+
+    /**
+     * Largest dts of the last queued packets of the streams, in
+     * AV_TIME_BASE units, and the stream it belongs to.
+     */
+    int64_t interleave_max_dts;
+    int interleave_max_dts_stream;
+
+    /**
+     * Number of streams which are not attachments, VP8 or VP9, in total and
+     * among those with queued packets. Muxing only.
+     */
+    int nb_delay_streams;
+    int nb_queued_delay_streams;
+
     /**
      * This buffer is only needed when packets were already buffered but
      * not decoded, for example to get the codec parameters in MPEG
@@ -162,6 +190,13 @@ struct AVStreamInternal {
      * Whether the internal avctx needs to be updated from codecpar (after a late change to codecpar)
      */
     int need_context_update;
+
+    /**
+     * Packets of the stream in the interleaving queue of the muxer, the
+     * last one is AVStream.last_in_packet_buffer.
+     */
+    struct AVPacketList *interleave_queue;
+    int64_t interleave_seq;     ///< when the first queued packet became first
 };
 
 #ifdef __GNUC__
@@ -194,13 +229,31 @@ char *ff_data_to_hex(char *buf, const uint8_t *src, int size, int lowercase);
 int ff_hex_to_data(uint8_t *data, const char *p);
 
 /**
- * Add packet to AVFormatContext->packet_buffer list, determining its
- * interleaved position using compare() function argument.
+ * Add packet to the interleaving queue, determining its interleaved
+ * position using compare() function argument. compare() must order packets
+ * of different streams strictly.
  * @return 0, or < 0 on error
  */
 int ff_interleave_add_packet(AVFormatContext *s, AVPacket *pkt,
                              int (*compare)(AVFormatContext *, AVPacket *, AVPacket *));
 
+/**
+ * Return the first packet of the interleaving queue without removing it,
+ * or NULL if the queue is empty.
+ */
+const AVPacket *ff_interleave_queue_peek(AVFormatContext *s);
+
+/**
+ * Remove the first packet from the interleaving queue, which must not be
+ * empty, and return it in out. The caller owns the packet.
+ */
+void ff_interleave_queue_pop(AVFormatContext *s, AVPacket *out);
+
+/**
+ * Discard all packets of the interleaving queue and free it.
+ */
+void ff_interleave_queue_free(AVFormatContext *s);
+
 void ff_read_frame_flush(AVFormatContext *s);
 
 #define NTP_OFFSET 2208988800ULL
@@ -232,6 +232,15 @@ static int validate_codec_tag(AVFormatContext *s, AVStream *st)
 }
 
 
+/* Streams that do not hold back the max_interleave_delta check in
+ * ff_interleave_packet_per_dts() while they have no packets queued. */
+static int is_delay_stream(const AVStream *st)
+{
+    return st->codecpar->codec_type != AVMEDIA_TYPE_ATTACHMENT &&
+           st->codecpar->codec_id   != AV_CODEC_ID_VP8 &&
+           st->codecpar->codec_id   != AV_CODEC_ID_VP9;
+}
+
 static int init_muxer(AVFormatContext *s, AVDictionary **options)
 {
     int ret = 0, i;
@@ -391,6 +400,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
         if (par->codec_type != AVMEDIA_TYPE_ATTACHMENT)
             s->internal->nb_interleaved_streams++;
+        s->internal->nb_delay_streams += is_delay_stream(st);
     }
 
     if (!s->priv_data && of->priv_data_size > 0) {
@@ -924,14 +934,106 @@ int av_write_frame(AVFormatContext *s, AVPacket *pkt)
 
 #define CHUNK_START 0x1000
 
+/* The interleaving queue keeps the packets of every stream in order in
+ * AVStreamInternal.interleave_queue. The streams with queued packets form a
+ * binary min-heap ordered by their first packet, so that the next packet is
+ * found in O(log(nb_streams)) instead of by walking all queued packets.
+ * When chunking, a packet that does not start a chunk stays right behind
+ * the previous packet of its stream: such packets go first, the one that
+ * most recently became the first of its stream before the others. */
+static int interleave_before(AVFormatContext *s, int a, int b)
+{
+    AVStreamInternal *sta = s->streams[a]->internal;
+    AVStreamInternal *stb = s->streams[b]->internal;
+    AVPacket *pkt_a = &sta->interleave_queue->pkt;
+    AVPacket *pkt_b = &stb->interleave_queue->pkt;
+
+    if (s->max_chunk_size || s->max_chunk_duration) {
+        int cont_a = !(pkt_a->flags & CHUNK_START);
+        int cont_b = !(pkt_b->flags & CHUNK_START);
+        if (cont_a && cont_b)
+            return sta->interleave_seq > stb->interleave_seq;
+        if (cont_a || cont_b)
+            return cont_a;
+    }
+    return s->internal->interleave_compare(s, pkt_b, pkt_a);
+}
+
+static void interleave_sift_up(AVFormatContext *s, int i)
+{
+    int *heap = s->internal->interleave_heap;
+    int idx   = heap[i];
+
+    while (i > 0) {
+        int parent = (i - 1) >> 1;
+        if (!interleave_before(s, idx, heap[parent]))
+            break;
+        heap[i] = heap[parent];
+        i       = parent;
+    }
+    heap[i] = idx;
+}
+
+static void interleave_sift_down(AVFormatContext *s, int i)
+{
+    int *heap = s->internal->interleave_heap;
+    int n     = s->internal->nb_interleave_heap;
+    int idx   = heap[i];
+
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && interleave_before(s, heap[child + 1], heap[child]))
+            child++;
+        if (!interleave_before(s, heap[child], idx))
+            break;
+        heap[i] = heap[child];
+        i       = child;
+    }
+    heap[i] = idx;
+}
+
+/* Find the largest dts among the last queued packets of all streams. It is
+ * kept up to date as packets are added, and only searched again when the
+ * stream holding it is emptied or goes back in time. */
+static void interleave_update_max_dts(AVFormatContext *s)
+{
+    AVFormatInternal *si = s->internal;
+    int i;
+
+    si->interleave_max_dts        = INT64_MIN;
+    si->interleave_max_dts_stream = -1;
+    for (i = 0; i < si->nb_interleave_heap; i++) {
+        AVStream *st = s->streams[si->interleave_heap[i]];
+        int64_t dts  = av_rescale_q(st->last_in_packet_buffer->pkt.dts,
+                                    st->time_base, AV_TIME_BASE_Q);
+        if (dts > si->interleave_max_dts) {
+            si->interleave_max_dts        = dts;
+            si->interleave_max_dts_stream = st->index;
+        }
+    }
+}
+
 int ff_interleave_add_packet(AVFormatContext *s, AVPacket *pkt,
                              int (*compare)(AVFormatContext *, AVPacket *, AVPacket *))
 {
     int ret;
-    AVPacketList **next_point, *this_pktl;
+    int64_t dts;
+    AVPacketList *this_pktl;
+    AVFormatInternal *si = s->internal;
     AVStream *st   = s->streams[pkt->stream_index];
     int chunked    = s->max_chunk_size || s->max_chunk_duration;
 
+    if (si->interleave_heap_size < s->nb_streams) {
+        int *heap = av_realloc_array(si->interleave_heap, s->nb_streams,
+                                     sizeof(*heap));
+        if (!heap)
+            return AVERROR(ENOMEM);
+        si->interleave_heap      = heap;
+        si->interleave_heap_size = s->nb_streams;
+    }
+
     this_pktl      = av_mallocz(sizeof(AVPacketList));
     if (!this_pktl)
         return AVERROR(ENOMEM);
@@ -949,12 +1051,6 @@ int ff_interleave_add_packet(AVFormatContext *s, AVPacket *pkt,
         }
     }
 
-    if (s->streams[pkt->stream_index]->last_in_packet_buffer) {
-        next_point = &(st->last_in_packet_buffer->next);
-    } else {
-        next_point = &s->internal->packet_buffer;
-    }
-
     if (chunked) {
         uint64_t max= av_rescale_q_rnd(s->max_chunk_duration, AV_TIME_BASE_Q, st->time_base, AV_ROUND_UP);
         st->interleaver_chunk_size     += pkt->size;
@@ -972,36 +1068,76 @@ int ff_interleave_add_packet(AVFormatContext *s, AVPacket *pkt,
                 st->interleaver_chunk_duration = 0;
         }
     }
-    if (*next_point) {
-        if (chunked && !(this_pktl->pkt.flags & CHUNK_START))
-            goto next_non_null;
-
-        if (compare(s, &s->internal->packet_buffer_end->pkt, pkt)) {
-            while (   *next_point
-                   && ((chunked && !((*next_point)->pkt.flags&CHUNK_START))
-                       || !compare(s, &(*next_point)->pkt, pkt)))
-                next_point = &(*next_point)->next;
-            if (*next_point)
-                goto next_non_null;
-        } else {
-            next_point = &(s->internal->packet_buffer_end->next);
-        }
-    }
-    av_assert1(!*next_point);
-
-    s->internal->packet_buffer_end = this_pktl;
-next_non_null:
 
-    this_pktl->next = *next_point;
+    si->interleave_compare = compare;
 
-    s->streams[pkt->stream_index]->last_in_packet_buffer =
-        *next_point                                      = this_pktl;
+    if (st->last_in_packet_buffer) {
+        st->last_in_packet_buffer->next = this_pktl;
+    } else {
+        st->internal->interleave_queue = this_pktl;
+        st->internal->interleave_seq   = ++si->interleave_seq;
+        si->nb_queued_delay_streams   += is_delay_stream(st);
+        si->interleave_heap[si->nb_interleave_heap] = pkt->stream_index;
+        interleave_sift_up(s, si->nb_interleave_heap++);
+    }
+    st->last_in_packet_buffer = this_pktl;
+
+    dts = av_rescale_q(pkt->dts, st->time_base, AV_TIME_BASE_Q);
+    if (si->nb_interleave_heap == 1 || dts >= si->interleave_max_dts) {
+        si->interleave_max_dts        = dts;
+        si->interleave_max_dts_stream = pkt->stream_index;
+    } else if (si->interleave_max_dts_stream == pkt->stream_index) {
+        interleave_update_max_dts(s);
+    }
 
     av_packet_unref(pkt);
 
     return 0;
 }
 
+const AVPacket *ff_interleave_queue_peek(AVFormatContext *s)
+{
+    AVFormatInternal *si = s->internal;
+
+    if (!si->nb_interleave_heap)
+        return NULL;
+    return &s->streams[si->interleave_heap[0]]->internal->interleave_queue->pkt;
+}
+
+void ff_interleave_queue_pop(AVFormatContext *s, AVPacket *out)
+{
+    AVFormatInternal *si = s->internal;
+    AVStream *st         = s->streams[si->interleave_heap[0]];
+    AVPacketList *pktl   = st->internal->interleave_queue;
+
+    *out = pktl->pkt;
+    st->internal->interleave_queue = pktl->next;
+    if (pktl->next) {
+        st->internal->interleave_seq = ++si->interleave_seq;
+    } else {
+        st->last_in_packet_buffer    = NULL;
+        si->nb_queued_delay_streams -= is_delay_stream(st);
+        si->interleave_heap[0] = si->interleave_heap[--si->nb_interleave_heap];
+        if (si->interleave_max_dts_stream == st->index)
+            interleave_update_max_dts(s);
+    }
+    if (si->nb_interleave_heap)
+        interleave_sift_down(s, 0);
+    av_freep(&pktl);
+}
+
+void ff_interleave_queue_free(AVFormatContext *s)
+{
+    AVPacket pkt;
+
+    while (ff_interleave_queue_peek(s)) {
+        ff_interleave_queue_pop(s, &pkt);
+        av_packet_unref(&pkt);
+    }
+    av_freep(&s->internal->interleave_heap);
+    s->internal->interleave_heap_size = 0;
+}
+
 static int interleave_compare_dts(AVFormatContext *s, AVPacket *next,
                                   AVPacket *pkt)
 {
@@ -1017,7 +1153,7 @@ static int interleave_compare_dts(AVFormatContext *s, AVPacket *next,
                -( next->dts*st2->time_base.num*AV_TIME_BASE - s->audio_preload*(int64_t)(st2->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)*st2->time_base.den)* st->time_base.den;
             ts2=0;
         }
-        comp= (ts>ts2) - (ts<ts2);
+        comp= (ts2>ts) - (ts2<ts);
     }
 
     if (comp == 0)
@@ -1028,52 +1164,31 @@ static int interleave_compare_dts(AVFormatContext *s, AVPacket *next,
 int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
                                  AVPacket *pkt, int flush)
 {
-    AVPacketList *pktl;
-    int stream_count = 0;
-    int noninterleaved_count = 0;
-    int i, ret;
+    AVFormatInternal *si = s->internal;
+    int stream_count, noninterleaved_count;
+    int ret;
 
     if (pkt) {
         if ((ret = ff_interleave_add_packet(s, pkt, interleave_compare_dts)) < 0)
             return ret;
     }
 
-    for (i = 0; i < s->nb_streams; i++) {
-        if (s->streams[i]->last_in_packet_buffer) {
-            ++stream_count;
-        } else if (s->streams[i]->codecpar->codec_type != AVMEDIA_TYPE_ATTACHMENT &&
-                   s->streams[i]->codecpar->codec_id != AV_CODEC_ID_VP8 &&
-                   s->streams[i]->codecpar->codec_id != AV_CODEC_ID_VP9) {
-            ++noninterleaved_count;
-        }
-    }
+    stream_count         = si->nb_interleave_heap;
+    noninterleaved_count = si->nb_delay_streams - si->nb_queued_delay_streams;
 
-    if (s->internal->nb_interleaved_streams == stream_count)
+    if (si->nb_interleaved_streams == stream_count)
         flush = 1;
 
     if (s->max_interleave_delta > 0 &&
-        s->internal->packet_buffer &&
+        stream_count &&
         !flush &&
-        s->internal->nb_interleaved_streams == stream_count+noninterleaved_count
+        si->nb_interleaved_streams == stream_count+noninterleaved_count
     ) {
-        AVPacket *top_pkt = &s->internal->packet_buffer->pkt;
-        int64_t delta_dts = INT64_MIN;
+        const AVPacket *top_pkt = ff_interleave_queue_peek(s);
         int64_t top_dts = av_rescale_q(top_pkt->dts,
                                        s->streams[top_pkt->stream_index]->time_base,
                                        AV_TIME_BASE_Q);
-
-        for (i = 0; i < s->nb_streams; i++) {
-            int64_t last_dts;
-            const AVPacketList *last = s->streams[i]->last_in_packet_buffer;
-
-            if (!last)
-                continue;
-
-            last_dts = av_rescale_q(last->pkt.dts,
-                                    s->streams[i]->time_base,
-                                    AV_TIME_BASE_Q);
-            delta_dts = FFMAX(delta_dts, last_dts - top_dts);
-        }
+        int64_t delta_dts = si->interleave_max_dts - top_dts;
 
         if (delta_dts > s->max_interleave_delta) {
             av_log(s, AV_LOG_DEBUG,
@@ -1085,19 +1200,7 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
     }
 
     if (stream_count && flush) {
-        AVStream *st;
-        pktl = s->internal->packet_buffer;
-        *out = pktl->pkt;
-        st   = s->streams[out->stream_index];
-
-        s->internal->packet_buffer = pktl->next;
-        if (!s->internal->packet_buffer)
-            s->internal->packet_buffer_end = NULL;
-
-        if (st->last_in_packet_buffer == pktl)
-            st->last_in_packet_buffer = NULL;
-        av_freep(&pktl);
-
+        ff_interleave_queue_pop(s, out);
         return 1;
     } else {
         av_init_packet(out);
@@ -1107,21 +1210,17 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
 
 const AVPacket *ff_interleaved_peek(AVFormatContext *s, int stream, int64_t *ts_offset)
 {
-    AVPacketList *pktl = s->internal->packet_buffer;
-    while (pktl) {
-        if (pktl->pkt.stream_index == stream) {
-            AVPacket *pkt = &pktl->pkt;
-            AVStream *st = s->streams[pkt->stream_index];
-            *ts_offset = st->mux_ts_offset;
+    AVStream *st       = s->streams[stream];
+    AVPacketList *pktl = st->internal->interleave_queue;
 
-            if (s->output_ts_offset)
-                *ts_offset += av_rescale_q(s->output_ts_offset, AV_TIME_BASE_Q, st->time_base);
+    if (!pktl)
+        return NULL;
 
-            return pkt;
-        }
-        pktl = pktl->next;
-    }
-    return NULL;
+    *ts_offset = st->mux_ts_offset;
+    if (s->output_ts_offset)
+        *ts_offset += av_rescale_q(s->output_ts_offset, AV_TIME_BASE_Q, st->time_base);
+
+    return &pktl->pkt;
 }
 
 /**
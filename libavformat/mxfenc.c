@@ -2584,53 +2584,55 @@ end:
     return err < 0 ? err : 0;
 }
 
+static int mxf_compare_timestamps(AVFormatContext *s, AVPacket *next, AVPacket *pkt)
+{
+    MXFStreamContext *sc  = s->streams[pkt ->stream_index]->priv_data;
+    MXFStreamContext *sc2 = s->streams[next->stream_index]->priv_data;
+
+    return next->dts > pkt->dts ||
+        (next->dts == pkt->dts && sc->order < sc2->order);
+}
+
 static int mxf_interleave_get_packet(AVFormatContext *s, AVPacket *out, AVPacket *pkt, int flush)
 {
-    int i, stream_count = 0;
+    int i, ret, stream_count = 0;
 
     for (i = 0; i < s->nb_streams; i++)
         stream_count += !!s->streams[i]->last_in_packet_buffer;
 
     if (stream_count && (s->nb_streams == stream_count || flush)) {
-        AVPacketList *pktl = s->internal->packet_buffer;
         if (s->nb_streams != stream_count) {
-            AVPacketList *last = NULL;
-            // find last packet in edit unit
-            while (pktl) {
-                if (!stream_count || pktl->pkt.stream_index == 0)
-                    break;
-                last = pktl;
-                pktl = pktl->next;
-                stream_count--;
-            }
+            const AVPacket *next;
+            AVPacket *edit_unit, tmp;
+            int nb_packets = 0;
+
+            edit_unit = av_malloc_array(stream_count, sizeof(*edit_unit));
+            if (!edit_unit)
+                return AVERROR(ENOMEM);
+            // take the packets of the last edit unit
+            while ((next = ff_interleave_queue_peek(s)) &&
+                   next->stream_index != 0 && nb_packets < stream_count)
+                ff_interleave_queue_pop(s, &edit_unit[nb_packets++]);
             // purge packet queue
-            while (pktl) {
-                AVPacketList *next = pktl->next;
-
-                if(s->streams[pktl->pkt.stream_index]->last_in_packet_buffer == pktl)
-                    s->streams[pktl->pkt.stream_index]->last_in_packet_buffer= NULL;
-                av_packet_unref(&pktl->pkt);
-                av_freep(&pktl);
-                pktl = next;
+            while (ff_interleave_queue_peek(s)) {
+                ff_interleave_queue_pop(s, &tmp);
+                av_packet_unref(&tmp);
             }
-            if (last)
-                last->next = NULL;
-            else {
-                s->internal->packet_buffer = NULL;
-                s->internal->packet_buffer_end= NULL;
-                goto out;
+            // and queue them again, in the same order
+            for (ret = 0, i = 0; i < nb_packets; i++) {
+                if (ret >= 0)
+                    ret = ff_interleave_add_packet(s, &edit_unit[i], mxf_compare_timestamps);
+                av_packet_unref(&edit_unit[i]);
             }
-            pktl = s->internal->packet_buffer;
+            av_free(edit_unit);
+            if (ret < 0)
+                return ret;
+            if (!nb_packets)
+                goto out;
         }
 
-        *out = pktl->pkt;
+        ff_interleave_queue_pop(s, out);
         av_log(s, AV_LOG_TRACE, "out st:%d dts:%"PRId64"\n", (*out).stream_index, (*out).dts);
-        s->internal->packet_buffer = pktl->next;
-        if(s->streams[pktl->pkt.stream_index]->last_in_packet_buffer == pktl)
-            s->streams[pktl->pkt.stream_index]->last_in_packet_buffer= NULL;
-        if(!s->internal->packet_buffer)
-            s->internal->packet_buffer_end= NULL;
-        av_freep(&pktl);
         return 1;
     } else {
     out:
@@ -2639,15 +2641,6 @@ static int mxf_interleave_get_packet(AVFormatContext *s, AVPacket *out, AVPacket
     }
 }
 
-static int mxf_compare_timestamps(AVFormatContext *s, AVPacket *next, AVPacket *pkt)
-{
-    MXFStreamContext *sc  = s->streams[pkt ->stream_index]->priv_data;
-    MXFStreamContext *sc2 = s->streams[next->stream_index]->priv_data;
-
-    return next->dts > pkt->dts ||
-        (next->dts == pkt->dts && sc->order < sc2->order);
-}
-
 static int mxf_interleave(AVFormatContext *s, AVPacket *out, AVPacket *pkt, int flush)
 {
     return ff_audio_rechunk_interleave(s, out, pkt, flush,
@@ -0,0 +1,216 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/opt.h"
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+
+#define BENCH_STREAMS 64
+#define BENCH_PACKETS 2000
+
+typedef struct StreamDesc {
+    enum AVMediaType type;
+    enum AVCodecID codec_id;
+    AVRational time_base;
+    int duration;       ///< of a packet, in time_base units
+    int every;          ///< packets are sent for one in every this many ticks
+    int burst;          ///< packets passed to the muxer in a row
+} StreamDesc;
+
+static const StreamDesc descs[] = {
+    { AVMEDIA_TYPE_VIDEO,    AV_CODEC_ID_MPEG2VIDEO, {    1,    25 },    1, 1, 2 },
+    { AVMEDIA_TYPE_AUDIO,    AV_CODEC_ID_MP2,        {    1, 48000 }, 1152, 1, 3 },
+    { AVMEDIA_TYPE_AUDIO,    AV_CODEC_ID_AC3,        {    1, 44100 }, 1536, 1, 1 },
+    { AVMEDIA_TYPE_VIDEO,    AV_CODEC_ID_VP8,        { 1001, 30000 },    1, 1, 4 },
+    { AVMEDIA_TYPE_SUBTITLE, AV_CODEC_ID_SUBRIP,     {    1,  1000 }, 1500, 7, 1 },
+    { AVMEDIA_TYPE_AUDIO,    AV_CODEC_ID_MP2,        {    1, 90000 }, 2160, 1, 2 },
+    { AVMEDIA_TYPE_SUBTITLE, AV_CODEC_ID_ASS,        {    1,    10 },    1, 3, 1 },
+};
+
+static int discard_packet(void *opaque, uint8_t *buf, int size)
+{
+    return size;
+}
+
+static int add_streams(AVFormatContext *s, int nb_streams)
+{
+    int i;
+
+    for (i = 0; i < nb_streams; i++) {
+        const StreamDesc *d = &descs[i % FF_ARRAY_ELEMS(descs)];
+        AVStream *st = avformat_new_stream(s, NULL);
+
+        if (!st)
+            return AVERROR(ENOMEM);
+        st->time_base            = d->time_base;
+        st->codecpar->codec_type = d->type;
+        st->codecpar->codec_id   = d->codec_id;
+        if (d->type == AVMEDIA_TYPE_VIDEO) {
+            st->codecpar->width  = 352;
+            st->codecpar->height = 288;
+        } else if (d->type == AVMEDIA_TYPE_AUDIO) {
+            st->codecpar->sample_rate    = d->time_base.den;
+            st->codecpar->channels       = 2;
+            st->codecpar->channel_layout = AV_CH_LAYOUT_STEREO;
+            st->codecpar->frame_size     = d->duration;
+        }
+    }
+    if (!strcmp(s->oformat->name, "framecrc")) {
+        AVStream *st = avformat_new_stream(s, NULL);
+        if (!st)
+            return AVERROR(ENOMEM);
+        st->codecpar->codec_type = AVMEDIA_TYPE_ATTACHMENT;
+    }
+    return 0;
+}
+
+/* Pass nb_packets packets of every stream in bursts, so that the muxer
+ * sees them out of order and has to interleave them. */
+static int mux(AVFormatContext *s, int nb_streams, int nb_packets)
+{
+    uint8_t data[256];
+    int64_t ticks[BENCH_STREAMS] = { 0 };
+    int sent[BENCH_STREAMS] = { 0 };
+    int i, j, ret, left = nb_streams;
+
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = i * 7 + 3;
+
+    while (left) {
+        for (i = 0; i < nb_streams; i++) {
+            const StreamDesc *d = &descs[i % FF_ARRAY_ELEMS(descs)];
+            for (j = 0; j < d->burst && sent[i] < nb_packets; j++) {
+                AVPacket pkt;
+
+                av_init_packet(&pkt);
+                pkt.data         = data;
+                pkt.size         = 1 + (i * 13 + sent[i] * 7) % 200;
+                pkt.stream_index = i;
+                pkt.pts = pkt.dts = ticks[i] * d->every * d->duration;
+                pkt.duration     = d->duration;
+                pkt.flags        = AV_PKT_FLAG_KEY;
+                if ((ret = av_interleaved_write_frame(s, &pkt)) < 0)
+                    return ret;
+                ticks[i] += 1 + (sent[i] % 5 == 4);
+                if (++sent[i] == nb_packets)
+                    left--;
+            }
+        }
+    }
+    return av_write_trailer(s);
+}
+
+static int run(const char *format, int nb_streams, int nb_packets,
+               const char *options)
+{
+    AVFormatContext *s = NULL;
+    AVDictionary *opts = NULL;
+    uint8_t *iobuf = NULL;
+    int ret;
+
+    if ((ret = avformat_alloc_output_context2(&s, NULL, format, NULL)) < 0)
+        return ret;
+    s->flags |= AVFMT_FLAG_BITEXACT;
+    if (!strcmp(format, "framecrc")) {
+        ret = avio_open(&s->pb, "pipe:1", AVIO_FLAG_WRITE);
+    } else {
+        ret   = AVERROR(ENOMEM);
+        iobuf = av_malloc(32768);
+        if (iobuf)
+            s->pb = avio_alloc_context(iobuf, 32768, 1, NULL, NULL,
+                                       discard_packet, NULL);
+        if (s->pb)
+            ret = 0;
+    }
+    if (ret < 0)
+        goto end;
+    if ((ret = add_streams(s, nb_streams)) < 0)
+        goto end;
+    if ((ret = av_dict_parse_string(&opts, options ? options : "", "=", ",", 0)) < 0 ||
+        (ret = av_opt_set_dict(s, &opts)) < 0 ||
+        (ret = avformat_write_header(s, &opts)) < 0)
+        goto end;
+    ret = mux(s, nb_streams, nb_packets);
+
+end:
+    av_dict_free(&opts);
+    if (s->pb) {
+        if (iobuf) {
+            av_freep(&s->pb->buffer);
+            av_freep(&s->pb);
+        } else {
+            avio_closep(&s->pb);
+        }
+    } else {
+        av_free(iobuf);
+    }
+    avformat_free_context(s);
+    return ret;
+}
+
+static void bench(void)
+{
+    static const char *const formats[] = { "matroska", "mpegts" };
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(formats); i++) {
+        int64_t t = av_gettime_relative();
+        int ret   = run(formats[i], BENCH_STREAMS, BENCH_PACKETS, NULL);
+
+        t = av_gettime_relative() - t;
+        if (ret < 0) {
+            printf("%s: %s\n", formats[i], av_err2str(ret));
+            continue;
+        }
+        printf("%-8s %d streams: %6.2f us per packet\n", formats[i],
+               BENCH_STREAMS, (double)t / (BENCH_STREAMS * BENCH_PACKETS));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const options[] = {
+        NULL,
+        "max_interleave_delta=100000",
+        "max_interleave_delta=0",
+        "chunk_size=300",
+        "chunk_duration=150000,max_interleave_delta=0",
+        "audio_preload=50000",
+    };
+    int i, ret;
+
+    av_register_all();
+
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        bench();
+        return 0;
+    }
+
+    for (i = 0; i < FF_ARRAY_ELEMS(options); i++) {
+        printf("#options: %s\n", options[i] ? options[i] : "");
+        fflush(stdout);
+        if ((ret = run("framecrc", 14, 24, options[i])) < 0) {
+            fprintf(stderr, "muxing failed: %s\n", av_err2str(ret));
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,408 @@
+/*
+ * Segment upload queue for segmenting muxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/avstring.h"
+#include "libavutil/mem.h"
+#if HAVE_THREADS
+#include "libavutil/thread.h"
+#endif
+#include "avformat.h"
+#include "avio_internal.h"
+#include "http.h"
+#include "internal.h"
+#include "uploadqueue.h"
+#include "url.h"
+
+#define MAX_IDLE_CONNECTIONS 4
+
+typedef struct UploadFile {
+    AVIOContext *pb;
+    char *url;
+    AVDictionary *options;
+    int buffered;                   ///< written to memory for an async upload
+} UploadFile;
+
+typedef struct UploadJob {
+    char *url;
+    AVDictionary *options;
+    uint8_t *data;
+    int size;
+    struct UploadJob *next;
+} UploadJob;
+
+struct UploadQueue {
+    AVFormatContext *s;
+    int persistent;
+    int async;
+    int64_t max_size;
+
+    UploadFile *files;
+    int nb_files;
+
+    /* finished uploads whose connection can carry the next request; only
+     * used by the thread doing the uploads */
+    AVIOContext *idle[MAX_IDLE_CONNECTIONS];
+    int nb_idle;
+
+#if HAVE_THREADS
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    UploadJob *jobs, **jobs_tail;   ///< the head job is being uploaded
+    int64_t queued_size;
+    int finish;
+#endif
+    int error;                      ///< first error of an async upload
+};
+
+static int is_http_url(const char *url)
+{
+    const char *proto = avio_find_protocol_name(url);
+
+    return proto && (!strcmp(proto, "http") || !strcmp(proto, "https"));
+}
+
+static URLContext *http_urlcontext(AVIOContext *pb)
+{
+    URLContext *uc = ffio_geturlcontext(pb);
+
+    if (!uc || !uc->prot ||
+        (strcmp(uc->prot->name, "http") && strcmp(uc->prot->name, "https")))
+        return NULL;
+    return uc;
+}
+
+static int upload_connect(UploadQueue *q, AVIOContext **pb, const char *url,
+                          AVDictionary *options)
+{
+    AVFormatContext *s = q->s;
+    AVDictionary *opts = NULL;
+    int ret;
+
+    av_dict_copy(&opts, options, 0);
+    if (q->persistent)
+        av_dict_set(&opts, "multiple_requests", "1", 0);
+
+    while (q->nb_idle) {
+        AVIOContext *conn = q->idle[--q->nb_idle];
+        URLContext *uc = http_urlcontext(conn);
+        AVDictionary *tmp = NULL;
+
+        av_dict_copy(&tmp, opts, 0);
+        ret = CONFIG_HTTP_PROTOCOL && uc ? ff_http_do_new_request2(uc, url, &tmp)
+                                         : AVERROR(ENOSYS);
+        av_dict_free(&tmp);
+        if (ret >= 0) {
+            conn->pos         = 0;
+            conn->eof_reached = 0;
+            conn->error       = 0;
+            *pb = conn;
+            av_dict_free(&opts);
+            return 0;
+        }
+        ff_format_io_close(s, &conn);
+    }
+
+    ret = s->io_open(s, pb, url, AVIO_FLAG_WRITE, &opts);
+    av_dict_free(&opts);
+    return ret;
+}
+
+/* End the upload on *pb, keeping the connection for the next one if
+ * possible. */
+static int upload_finish(UploadQueue *q, AVIOContext **pb)
+{
+    URLContext *uc = q->persistent ? http_urlcontext(*pb) : NULL;
+    int ret;
+
+    if (!uc || q->nb_idle == MAX_IDLE_CONNECTIONS) {
+        ff_format_io_close(q->s, pb);
+        return 0;
+    }
+
+    avio_flush(*pb);
+    ret = (*pb)->error;
+    if (ret >= 0)
+        ret = ffurl_shutdown(uc, AVIO_FLAG_WRITE);
+    if (ret < 0) {
+        ff_format_io_close(q->s, pb);
+        return ret;
+    }
+    q->idle[q->nb_idle++] = *pb;
+    *pb = NULL;
+    return 0;
+}
+
+static void close_idle_connections(UploadQueue *q)
+{
+    while (q->nb_idle)
+        ff_format_io_close(q->s, &q->idle[--q->nb_idle]);
+}
+
+#if HAVE_THREADS
+static int upload_job(UploadQueue *q, UploadJob *job)
+{
+    AVIOContext *pb = NULL;
+    int ret;
+
+    ret = upload_connect(q, &pb, job->url, job->options);
+    if (ret < 0) {
+        av_log(q->s, AV_LOG_ERROR, "Failed to open %s for upload: %s\n",
+               job->url, av_err2str(ret));
+        return ret;
+    }
+    avio_write(pb, job->data, job->size);
+    ret = upload_finish(q, &pb);
+    if (ret < 0)
+        av_log(q->s, AV_LOG_ERROR, "Failed to upload %s: %s\n",
+               job->url, av_err2str(ret));
+    return ret;
+}
+
+static void free_job(UploadJob *job)
+{
+    av_freep(&job->url);
+    av_dict_free(&job->options);
+    av_freep(&job->data);
+    av_free(job);
+}
+
+static void *upload_thread(void *arg)
+{
+    UploadQueue *q = arg;
+
+    pthread_mutex_lock(&q->lock);
+    for (;;) {
+        UploadJob *job;
+        int ret;
+
+        while (!q->jobs && !q->finish)
+            pthread_cond_wait(&q->cond, &q->lock);
+        if (!q->jobs)
+            break;
+        job = q->jobs;
+        pthread_mutex_unlock(&q->lock);
+
+        ret = upload_job(q, job);
+
+        pthread_mutex_lock(&q->lock);
+        q->jobs = job->next;
+        if (!q->jobs)
+            q->jobs_tail = &q->jobs;
+        q->queued_size -= job->size;
+        if (ret < 0 && !q->error)
+            q->error = ret;
+        pthread_cond_broadcast(&q->cond);
+        free_job(job);
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    close_idle_connections(q);
+    return NULL;
+}
+
+static int upload_enqueue(UploadQueue *q, UploadFile *file)
+{
+    UploadJob *job = av_mallocz(sizeof(*job));
+    int ret;
+
+    if (!job) {
+        ffio_free_dyn_buf(&file->pb);
+        return AVERROR(ENOMEM);
+    }
+    job->size    = avio_close_dyn_buf(file->pb, &job->data);
+    job->url     = file->url;
+    job->options = file->options;
+    file->pb      = NULL;
+    file->url     = NULL;
+    file->options = NULL;
+
+    pthread_mutex_lock(&q->lock);
+    while (q->queued_size && q->queued_size + job->size > q->max_size)
+        pthread_cond_wait(&q->cond, &q->lock);
+    *q->jobs_tail = job;
+    q->jobs_tail  = &job->next;
+    q->queued_size += job->size;
+    pthread_cond_broadcast(&q->cond);
+    ret = q->error;
+    pthread_mutex_unlock(&q->lock);
+    return ret;
+}
+
+static int start_thread(UploadQueue *q)
+{
+    int ret;
+
+    q->jobs_tail = &q->jobs;
+    if ((ret = pthread_mutex_init(&q->lock, NULL)))
+        return AVERROR(ret);
+    if ((ret = pthread_cond_init(&q->cond, NULL))) {
+        pthread_mutex_destroy(&q->lock);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_create(&q->thread, NULL, upload_thread, q))) {
+        pthread_cond_destroy(&q->cond);
+        pthread_mutex_destroy(&q->lock);
+        return AVERROR(ret);
+    }
+    return 0;
+}
+
+static int stop_thread(UploadQueue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    q->finish = 1;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+
+    pthread_join(q->thread, NULL);
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    return q->error;
+}
+#endif /* HAVE_THREADS */
+
+int ff_upload_queue_alloc(UploadQueue **pq, AVFormatContext *s,
+                          int persistent, int async, int64_t max_size)
+{
+    UploadQueue *q = av_mallocz(sizeof(*q));
+
+    if (!q)
+        return AVERROR(ENOMEM);
+    q->s          = s;
+    q->persistent = persistent;
+    q->max_size   = max_size;
+
+    if (async) {
+#if HAVE_THREADS
+        int ret;
+        if ((ret = start_thread(q)) < 0) {
+            av_free(q);
+            return ret;
+        }
+        q->async = 1;
+#else
+        av_log(s, AV_LOG_WARNING, "Async upload requires threads, uploading synchronously\n");
+#endif
+    }
+
+    *pq = q;
+    return 0;
+}
+
+int ff_upload_queue_open(UploadQueue *q, AVIOContext **pb, const char *url,
+                         AVDictionary **options)
+{
+    AVFormatContext *s = q->s;
+    UploadFile *files, *file;
+    int ret;
+
+    if ((!q->persistent && !q->async) || !is_http_url(url))
+        return s->io_open(s, pb, url, AVIO_FLAG_WRITE, options);
+
+    files = av_realloc_array(q->files, q->nb_files + 1, sizeof(*q->files));
+    if (!files)
+        return AVERROR(ENOMEM);
+    q->files = files;
+    file = &q->files[q->nb_files];
+    memset(file, 0, sizeof(*file));
+
+    if (q->async) {
+        if (!(file->url = av_strdup(url)))
+            return AVERROR(ENOMEM);
+        if (options)
+            av_dict_copy(&file->options, *options, 0);
+        if ((ret = avio_open_dyn_buf(pb)) < 0) {
+            av_freep(&file->url);
+            av_dict_free(&file->options);
+            return ret;
+        }
+        file->buffered = 1;
+    } else if ((ret = upload_connect(q, pb, url, options ? *options : NULL)) < 0) {
+        return ret;
+    }
+
+    file->pb = *pb;
+    q->nb_files++;
+    return 0;
+}
+
+int ff_upload_queue_close(UploadQueue *q, AVIOContext **pb)
+{
+    UploadFile file;
+    int i, ret;
+
+    if (!*pb)
+        return 0;
+
+    for (i = 0; i < q->nb_files; i++)
+        if (q->files[i].pb == *pb)
+            break;
+    if (i == q->nb_files) {
+        ff_format_io_close(q->s, pb);
+        return 0;
+    }
+    file = q->files[i];
+    q->files[i] = q->files[--q->nb_files];
+    *pb = NULL;
+
+#if HAVE_THREADS
+    if (file.buffered)
+        ret = upload_enqueue(q, &file);
+    else
+#endif
+        ret = upload_finish(q, &file.pb);
+
+    av_freep(&file.url);
+    av_dict_free(&file.options);
+    return ret;
+}
+
+int ff_upload_queue_free(UploadQueue **pq)
+{
+    UploadQueue *q = *pq;
+    int ret = 0;
+
+    if (!q)
+        return 0;
+
+    while (q->nb_files) {
+        UploadFile *file = &q->files[--q->nb_files];
+        if (file->buffered)
+            ffio_free_dyn_buf(&file->pb);
+        else
+            ff_format_io_close(q->s, &file->pb);
+        av_freep(&file->url);
+        av_dict_free(&file->options);
+    }
+    av_freep(&q->files);
+
+#if HAVE_THREADS
+    if (q->async)
+        ret = stop_thread(q);
+#endif
+    close_idle_connections(q);
+
+    av_freep(pq);
+    return ret;
+}
@@ -0,0 +1,73 @@
+/*
+ * Segment upload queue for segmenting muxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_UPLOADQUEUE_H
+#define AVFORMAT_UPLOADQUEUE_H
+
+#include <stdint.h>
+
+#include "libavutil/dict.h"
+#include "avformat.h"
+
+/**
+ * Output of the segment and playlist files of a muxer to HTTP servers.
+ *
+ * Files are opened and closed through the queue instead of
+ * AVFormatContext.io_open/io_close. With persistent set, the HTTP
+ * connection of a finished upload is used again for the next one. With
+ * async set, files are written to memory and uploaded in order by a
+ * background thread, so that a slow server does not stall the muxer until
+ * max_size bytes are waiting. URLs of other protocols are always opened
+ * directly.
+ */
+typedef struct UploadQueue UploadQueue;
+
+/**
+ * Allocate an upload queue for the muxer s.
+ *
+ * @param max_size maximum number of bytes waiting for an async upload,
+ *                 ff_upload_queue_close() blocks above it
+ */
+int ff_upload_queue_alloc(UploadQueue **q, AVFormatContext *s,
+                          int persistent, int async, int64_t max_size);
+
+/**
+ * Open url for writing, like AVFormatContext.io_open().
+ */
+int ff_upload_queue_open(UploadQueue *q, AVIOContext **pb, const char *url,
+                         AVDictionary **options);
+
+/**
+ * Finish the file written to *pb and set *pb to NULL. With async, the
+ * upload is only queued.
+ *
+ * @return 0 or an error of this or of a previous async upload
+ */
+int ff_upload_queue_close(UploadQueue *q, AVIOContext **pb);
+
+/**
+ * Wait for the queued uploads, close the kept connections and free the
+ * queue.
+ *
+ * @return 0 or the error of an async upload
+ */
+int ff_upload_queue_free(UploadQueue **q);
+
+#endif /* AVFORMAT_UPLOADQUEUE_H */
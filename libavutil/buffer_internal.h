@@ -72,7 +72,20 @@ typedef struct BufferPoolEntry {
     struct BufferPoolEntry *next;
 } BufferPoolEntry;
 
+/**
+ * Number of free buffers a pool keeps in its lock-free slots.
+ */
+#define BUFFER_POOL_SLOTS 64
+
 struct AVBufferPool {
+    /*
+     * Free buffers are taken from and returned to these slots with atomic
+     * compare-and-swap. Since a slot only ever changes between NULL and an
+     * entry, this is not subject to the ABA problem of a lock-free linked
+     * list. Free buffers that do not fit are kept in the list below.
+     */
+    BufferPoolEntry * volatile slots[BUFFER_POOL_SLOTS];
+
     AVMutex mutex;
     BufferPoolEntry *pool;
 
@@ -87,8 +100,6 @@ struct AVBufferPool {
      */
     volatile int refcount;
 
-    volatile int nb_allocated;
-
     int size;
     void *opaque;
     AVBufferRef* (*alloc)(int size);
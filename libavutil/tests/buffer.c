@@ -0,0 +1,185 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/atomic.h"
+#include "libavutil/buffer.h"
+#include "libavutil/common.h"
+#include "libavutil/log.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#define BUF_SIZE    4096
+#define BUFS_HELD   4
+#define MAX_THREADS 16
+
+static volatile int nb_allocs;
+
+static AVBufferRef *counting_alloc(int size)
+{
+    avpriv_atomic_int_add_and_fetch(&nb_allocs, 1);
+    return av_buffer_alloc(size);
+}
+
+typedef struct Worker {
+    AVBufferPool *pool;
+    int id;
+    int iterations;
+    int check;
+    int errors;
+} Worker;
+
+/* Take a few buffers at a time from the pool and give them back. With check
+ * set, every buffer is tagged while held to catch one handed out twice. */
+static void *worker(void *arg)
+{
+    Worker *w = arg;
+    AVBufferRef *bufs[BUFS_HELD];
+    int i, j;
+
+    for (i = 0; i < w->iterations; i++) {
+        for (j = 0; j < BUFS_HELD; j++) {
+            bufs[j] = av_buffer_pool_get(w->pool);
+            if (!bufs[j]) {
+                w->errors++;
+                break;
+            }
+            if (w->check)
+                memset(bufs[j]->data, w->id * BUFS_HELD + j, 64);
+            else
+                bufs[j]->data[0] = j;
+        }
+        while (j--) {
+            if (w->check) {
+                int k;
+                for (k = 0; k < 64; k++)
+                    if (bufs[j]->data[k] != w->id * BUFS_HELD + j) {
+                        w->errors++;
+                        break;
+                    }
+            }
+            av_buffer_unref(&bufs[j]);
+        }
+    }
+    return NULL;
+}
+
+static int run_workers(AVBufferPool *pool, int nb_threads, int iterations,
+                       int check)
+{
+    Worker workers[MAX_THREADS] = { { 0 } };
+#if HAVE_THREADS
+    pthread_t threads[MAX_THREADS];
+#endif
+    int i, errors = 0;
+
+    for (i = 0; i < nb_threads; i++) {
+        workers[i].pool       = pool;
+        workers[i].id         = i;
+        workers[i].iterations = iterations;
+        workers[i].check      = check;
+    }
+#if HAVE_THREADS
+    for (i = 0; i < nb_threads; i++)
+        if (pthread_create(&threads[i], NULL, worker, &workers[i]))
+            return -1;
+    for (i = 0; i < nb_threads; i++)
+        pthread_join(threads[i], NULL);
+#else
+    for (i = 0; i < nb_threads; i++)
+        worker(&workers[i]);
+#endif
+    for (i = 0; i < nb_threads; i++)
+        errors += workers[i].errors;
+    return errors;
+}
+
+/* Buffers released to the pool must be reused, also beyond what the pool
+ * keeps ready in its fast path. */
+static int test_reuse(void)
+{
+    AVBufferPool *pool = av_buffer_pool_init(BUF_SIZE, counting_alloc);
+    AVBufferRef *bufs[256];
+    int i, n, ret = 0;
+
+    if (!pool)
+        return 1;
+    for (n = 1; n <= FF_ARRAY_ELEMS(bufs); n *= 4) {
+        nb_allocs = 0;
+        for (i = 0; i < n; i++)
+            bufs[i] = av_buffer_pool_get(pool);
+        for (i = 0; i < n; i++)
+            av_buffer_unref(&bufs[i]);
+        for (i = 0; i < n; i++)
+            bufs[i] = av_buffer_pool_get(pool);
+        for (i = 0; i < n; i++)
+            av_buffer_unref(&bufs[i]);
+        if (nb_allocs > n) {
+            printf("%d buffers allocated for %d requests\n", nb_allocs, n);
+            ret = 1;
+        }
+    }
+    av_buffer_pool_uninit(&pool);
+    return ret;
+}
+
+static void bench(void)
+{
+    int nb_threads;
+
+    for (nb_threads = 1; nb_threads <= MAX_THREADS; nb_threads *= 2) {
+        AVBufferPool *pool = av_buffer_pool_init(BUF_SIZE, NULL);
+        int iterations = 1000000 / nb_threads;
+        int64_t t;
+
+        if (!pool)
+            return;
+        t = av_gettime_relative();
+        run_workers(pool, nb_threads, iterations, 0);
+        t = av_gettime_relative() - t;
+        printf("%2d threads: %6.1f ns per get/unref\n", nb_threads,
+               1000.0 * t / ((int64_t)iterations * nb_threads * BUFS_HELD));
+        av_buffer_pool_uninit(&pool);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    AVBufferPool *pool;
+    int ret;
+
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        bench();
+        return 0;
+    }
+
+    ret = test_reuse();
+
+    pool = av_buffer_pool_init(BUF_SIZE, NULL);
+    if (!pool)
+        return 1;
+    if (run_workers(pool, 8, 10000, 1)) {
+        printf("pool handed out a buffer in use\n");
+        ret = 1;
+    }
+    av_buffer_pool_uninit(&pool);
+
+    return ret;
+}
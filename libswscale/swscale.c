@@ -228,9 +228,10 @@ static void lumRangeFromJpeg16_c(int16_t *_dst, int width)
     if (DEBUG_SWSCALE_BUFFERS)                  \
         av_log(c, AV_LOG_DEBUG, __VA_ARGS__)
 
-static int swscale(SwsContext *c, const uint8_t *src[],
-                   int srcStride[], int srcSliceY,
-                   int srcSliceH, uint8_t *dst[], int dstStride[])
+static int swscale_lines(SwsContext *c, const uint8_t *src[],
+                         int srcStride[], int srcSliceY, int srcSliceH,
+                         uint8_t *dst[], int dstStride[],
+                         int dstSliceY, int dstSliceH)
 {
     /* load a few things into local vars to make the code more readable?
      * and faster */
@@ -264,7 +265,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     int chrBufIndex  = c->chrBufIndex;
     int lastInLumBuf = c->lastInLumBuf;
     int lastInChrBuf = c->lastInChrBuf;
-
+    const int dstEnd = dstSliceY + dstSliceH;
 
     int lumStart = 0;
     int lumEnd = c->descIndex[0];
@@ -309,12 +310,11 @@ static int swscale(SwsContext *c, const uint8_t *src[],
 
     if (dstStride[0]&15 || dstStride[1]&15 ||
         dstStride[2]&15 || dstStride[3]&15) {
-        static int warnedAlready = 0; // FIXME maybe move this into the context
-        if (flags & SWS_PRINT_INFO && !warnedAlready) {
+        if (flags & SWS_PRINT_INFO && !c->warned_unaligned_stride) {
             av_log(c, AV_LOG_WARNING,
                    "Warning: dstStride is not aligned!\n"
                    "         ->cannot do aligned memory accesses anymore\n");
-            warnedAlready = 1;
+            c->warned_unaligned_stride = 1;
         }
     }
 
@@ -323,11 +323,10 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         || dstStride[0]&15 || dstStride[1]&15 || dstStride[2]&15 || dstStride[3]&15
         || srcStride[0]&15 || srcStride[1]&15 || srcStride[2]&15 || srcStride[3]&15
     ) {
-        static int warnedAlready=0;
         int cpu_flags = av_get_cpu_flags();
-        if (HAVE_MMXEXT && (cpu_flags & AV_CPU_FLAG_SSE2) && !warnedAlready){
+        if (HAVE_MMXEXT && (cpu_flags & AV_CPU_FLAG_SSE2) && !c->warned_unaligned_data){
             av_log(c, AV_LOG_WARNING, "Warning: data is not aligned! This can lead to a speedloss\n");
-            warnedAlready=1;
+            c->warned_unaligned_data = 1;
         }
     }
 
@@ -337,7 +336,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = dstSliceY;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -369,7 +368,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         hout_slice->width = dstW;
     }
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
@@ -531,6 +530,14 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     return dstY - lastDstY;
 }
 
+static int swscale(SwsContext *c, const uint8_t *src[],
+                   int srcStride[], int srcSliceY,
+                   int srcSliceH, uint8_t *dst[], int dstStride[])
+{
+    return swscale_lines(c, src, srcStride, srcSliceY, srcSliceH,
+                         dst, dstStride, 0, c->dstH);
+}
+
 av_cold void ff_sws_init_range_convert(SwsContext *c)
 {
     c->lumConvertRange = NULL;
@@ -746,6 +753,83 @@ static void rgb48Toxyz12(struct SwsContext *c, uint16_t *dst,
     }
 }
 
+static void update_palette(SwsContext *c, const uint32_t *pal)
+{
+    int i;
+
+    for (i = 0; i < 256; i++) {
+        int r, g, b, y, u, v, a = 0xff;
+        if (c->srcFormat == AV_PIX_FMT_PAL8) {
+            uint32_t p = pal[i];
+            a = (p >> 24) & 0xFF;
+            r = (p >> 16) & 0xFF;
+            g = (p >>  8) & 0xFF;
+            b =  p        & 0xFF;
+        } else if (c->srcFormat == AV_PIX_FMT_RGB8) {
+            r = ( i >> 5     ) * 36;
+            g = ((i >> 2) & 7) * 36;
+            b = ( i       & 3) * 85;
+        } else if (c->srcFormat == AV_PIX_FMT_BGR8) {
+            b = ( i >> 6     ) * 85;
+            g = ((i >> 3) & 7) * 36;
+            r = ( i       & 7) * 36;
+        } else if (c->srcFormat == AV_PIX_FMT_RGB4_BYTE) {
+            r = ( i >> 3     ) * 255;
+            g = ((i >> 1) & 3) * 85;
+            b = ( i       & 1) * 255;
+        } else if (c->srcFormat == AV_PIX_FMT_GRAY8 || c->srcFormat == AV_PIX_FMT_GRAY8A) {
+            r = g = b = i;
+        } else {
+            av_assert1(c->srcFormat == AV_PIX_FMT_BGR4_BYTE);
+            b = ( i >> 3     ) * 255;
+            g = ((i >> 1) & 3) * 85;
+            r = ( i       & 1) * 255;
+        }
+#define RGB2YUV_SHIFT 15
+#define BY ( (int) (0.114 * 219 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
+#define BV (-(int) (0.081 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
+#define BU ( (int) (0.500 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
+#define GY ( (int) (0.587 * 219 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
+#define GV (-(int) (0.419 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
+#define GU (-(int) (0.331 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
+#define RY ( (int) (0.299 * 219 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
+#define RV ( (int) (0.500 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
+#define RU (-(int) (0.169 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
+
+        y = av_clip_uint8((RY * r + GY * g + BY * b + ( 33 << (RGB2YUV_SHIFT - 1))) >> RGB2YUV_SHIFT);
+        u = av_clip_uint8((RU * r + GU * g + BU * b + (257 << (RGB2YUV_SHIFT - 1))) >> RGB2YUV_SHIFT);
+        v = av_clip_uint8((RV * r + GV * g + BV * b + (257 << (RGB2YUV_SHIFT - 1))) >> RGB2YUV_SHIFT);
+        c->pal_yuv[i]= y + (u<<8) + (v<<16) + ((unsigned)a<<24);
+
+        switch (c->dstFormat) {
+        case AV_PIX_FMT_BGR32:
+#if !HAVE_BIGENDIAN
+        case AV_PIX_FMT_RGB24:
+#endif
+            c->pal_rgb[i]=  r + (g<<8) + (b<<16) + ((unsigned)a<<24);
+            break;
+        case AV_PIX_FMT_BGR32_1:
+#if HAVE_BIGENDIAN
+        case AV_PIX_FMT_BGR24:
+#endif
+            c->pal_rgb[i]= a + (r<<8) + (g<<16) + ((unsigned)b<<24);
+            break;
+        case AV_PIX_FMT_RGB32_1:
+#if HAVE_BIGENDIAN
+        case AV_PIX_FMT_RGB24:
+#endif
+            c->pal_rgb[i]= a + (b<<8) + (g<<16) + ((unsigned)r<<24);
+            break;
+        case AV_PIX_FMT_RGB32:
+#if !HAVE_BIGENDIAN
+        case AV_PIX_FMT_BGR24:
+#endif
+        default:
+            c->pal_rgb[i]=  b + (g<<8) + (r<<16) + ((unsigned)a<<24);
+        }
+    }
+}
+
 /**
  * swscale wrapper, so we don't need to export the SwsContext.
  * Assumes planar YUV to be in YUV order instead of YVU.
@@ -836,79 +920,8 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
         if (srcSliceY == 0) c->sliceDir = 1; else c->sliceDir = -1;
     }
 
-    if (usePal(c->srcFormat)) {
-        for (i = 0; i < 256; i++) {
-            int r, g, b, y, u, v, a = 0xff;
-            if (c->srcFormat == AV_PIX_FMT_PAL8) {
-                uint32_t p = ((const uint32_t *)(srcSlice[1]))[i];
-                a = (p >> 24) & 0xFF;
-                r = (p >> 16) & 0xFF;
-                g = (p >>  8) & 0xFF;
-                b =  p        & 0xFF;
-            } else if (c->srcFormat == AV_PIX_FMT_RGB8) {
-                r = ( i >> 5     ) * 36;
-                g = ((i >> 2) & 7) * 36;
-                b = ( i       & 3) * 85;
-            } else if (c->srcFormat == AV_PIX_FMT_BGR8) {
-                b = ( i >> 6     ) * 85;
-                g = ((i >> 3) & 7) * 36;
-                r = ( i       & 7) * 36;
-            } else if (c->srcFormat == AV_PIX_FMT_RGB4_BYTE) {
-                r = ( i >> 3     ) * 255;
-                g = ((i >> 1) & 3) * 85;
-                b = ( i       & 1) * 255;
-            } else if (c->srcFormat == AV_PIX_FMT_GRAY8 || c->srcFormat == AV_PIX_FMT_GRAY8A) {
-                r = g = b = i;
-            } else {
-                av_assert1(c->srcFormat == AV_PIX_FMT_BGR4_BYTE);
-                b = ( i >> 3     ) * 255;
-                g = ((i >> 1) & 3) * 85;
-                r = ( i       & 1) * 255;
-            }
-#define RGB2YUV_SHIFT 15
-#define BY ( (int) (0.114 * 219 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
-#define BV (-(int) (0.081 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
-#define BU ( (int) (0.500 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
-#define GY ( (int) (0.587 * 219 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
-#define GV (-(int) (0.419 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
-#define GU (-(int) (0.331 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
-#define RY ( (int) (0.299 * 219 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
-#define RV ( (int) (0.500 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
-#define RU (-(int) (0.169 * 224 / 255 * (1 << RGB2YUV_SHIFT) + 0.5))
-
-            y = av_clip_uint8((RY * r + GY * g + BY * b + ( 33 << (RGB2YUV_SHIFT - 1))) >> RGB2YUV_SHIFT);
-            u = av_clip_uint8((RU * r + GU * g + BU * b + (257 << (RGB2YUV_SHIFT - 1))) >> RGB2YUV_SHIFT);
-            v = av_clip_uint8((RV * r + GV * g + BV * b + (257 << (RGB2YUV_SHIFT - 1))) >> RGB2YUV_SHIFT);
-            c->pal_yuv[i]= y + (u<<8) + (v<<16) + ((unsigned)a<<24);
-
-            switch (c->dstFormat) {
-            case AV_PIX_FMT_BGR32:
-#if !HAVE_BIGENDIAN
-            case AV_PIX_FMT_RGB24:
-#endif
-                c->pal_rgb[i]=  r + (g<<8) + (b<<16) + ((unsigned)a<<24);
-                break;
-            case AV_PIX_FMT_BGR32_1:
-#if HAVE_BIGENDIAN
-            case AV_PIX_FMT_BGR24:
-#endif
-                c->pal_rgb[i]= a + (r<<8) + (g<<16) + ((unsigned)b<<24);
-                break;
-            case AV_PIX_FMT_RGB32_1:
-#if HAVE_BIGENDIAN
-            case AV_PIX_FMT_RGB24:
-#endif
-                c->pal_rgb[i]= a + (b<<8) + (g<<16) + ((unsigned)r<<24);
-                break;
-            case AV_PIX_FMT_RGB32:
-#if !HAVE_BIGENDIAN
-            case AV_PIX_FMT_BGR24:
-#endif
-            default:
-                c->pal_rgb[i]=  b + (g<<8) + (r<<16) + ((unsigned)a<<24);
-            }
-        }
-    }
+    if (usePal(c->srcFormat))
+        update_palette(c, (const uint32_t *)srcSlice[1]);
 
     if (c->src0Alpha && !c->dst0Alpha && isALPHA(c->dstFormat)) {
         uint8_t *base;
@@ -998,3 +1011,69 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     av_free(rgb0_tmp);
     return ret;
 }
+
+int sws_isSupportedDstSlice(struct SwsContext *c)
+{
+    return c->swscale == swscale         &&
+           !c->cascaded_context[0]       &&
+           !isBayer(c->srcFormat)        &&
+           !c->src0Alpha                 &&
+           !c->srcXYZ && !c->dstXYZ      &&
+           /* error diffusion carries state from one output row to the next */
+           c->dither != SWS_DITHER_ED;
+}
+
+int attribute_align_arg sws_scale_dst_slice(struct SwsContext *c,
+                                            const uint8_t * const src[],
+                                            const int srcStride[],
+                                            uint8_t *const dst[],
+                                            const int dstStride[],
+                                            int dstSliceY, int dstSliceH)
+{
+    const uint8_t *src2[4];
+    uint8_t *dst2[4];
+    int srcStride2[4], dstStride2[4];
+    int macro_height = 1 << c->chrDstVSubSample;
+
+    if (!srcStride || !dstStride || !dst || !src) {
+        av_log(c, AV_LOG_ERROR, "One of the input parameters to sws_scale_dst_slice() is NULL, please check the calling code\n");
+        return AVERROR(EINVAL);
+    }
+
+    if (dstSliceY < 0 || dstSliceH < 0 ||
+        (dstSliceY & (macro_height-1)) ||
+        ((dstSliceH & (macro_height-1)) && dstSliceY + dstSliceH != c->dstH) ||
+        dstSliceY + dstSliceH > c->dstH) {
+        av_log(c, AV_LOG_ERROR, "Destination slice parameters %d, %d are invalid\n", dstSliceY, dstSliceH);
+        return AVERROR(EINVAL);
+    }
+
+    if (!sws_isSupportedDstSlice(c))
+        return AVERROR(ENOSYS);
+
+    if (!dstSliceH)
+        return 0;
+
+    if (!check_image_pointers(src, c->srcFormat, srcStride)) {
+        av_log(c, AV_LOG_ERROR, "bad src image pointers\n");
+        return AVERROR(EINVAL);
+    }
+    if (!check_image_pointers((const uint8_t* const*)dst, c->dstFormat, dstStride)) {
+        av_log(c, AV_LOG_ERROR, "bad dst image pointers\n");
+        return AVERROR(EINVAL);
+    }
+
+    if (usePal(c->srcFormat))
+        update_palette(c, (const uint32_t *)src[1]);
+
+    memcpy(src2, src, sizeof(src2));
+    memcpy(dst2, dst, sizeof(dst2));
+    memcpy(srcStride2, srcStride, sizeof(srcStride2));
+    memcpy(dstStride2, dstStride, sizeof(dstStride2));
+
+    reset_ptr(src2, c->srcFormat);
+    reset_ptr((void*)dst2, c->dstFormat);
+
+    return swscale_lines(c, src2, srcStride2, 0, c->srcH,
+                         dst2, dstStride2, dstSliceY, dstSliceH);
+}
@@ -218,6 +218,45 @@ int sws_scale(struct SwsContext *c, const uint8_t *const srcSlice[],
               const int srcStride[], int srcSliceY, int srcSliceH,
               uint8_t *const dst[], const int dstStride[]);
 
+/**
+ * Return a positive value if c can scale separate destination slices
+ * with sws_scale_dst_slice(), 0 otherwise.
+ */
+int sws_isSupportedDstSlice(struct SwsContext *c);
+
+/**
+ * Scale the complete source image into a horizontal band of the
+ * destination image.
+ *
+ * Unlike sws_scale(), the context keeps no state between calls, so
+ * distinct bands of the same image may be produced in any order. Bands
+ * of one image may be scaled concurrently, provided that each thread
+ * uses its own context created with the same parameters.
+ *
+ * @param c          the scaling context previously created with
+ *                   sws_getContext()
+ * @param src        the array containing the pointers to the planes of
+ *                   the whole source image
+ * @param srcStride  the array containing the strides for each plane of
+ *                   the source image
+ * @param dst        the array containing the pointers to the planes of
+ *                   the whole destination image
+ * @param dstStride  the array containing the strides for each plane of
+ *                   the destination image
+ * @param dstSliceY  the first row of the destination band; it must be a
+ *                   multiple of the vertical chroma subsampling factor
+ * @param dstSliceH  the number of rows of the destination band; it must
+ *                   be a multiple of the vertical chroma subsampling factor
+ *                   unless the band ends at the bottom of the image
+ * @return           the height of the output band or a negative error
+ *                   code, AVERROR(ENOSYS) if the context does not support
+ *                   destination slices
+ * @see sws_isSupportedDstSlice()
+ */
+int sws_scale_dst_slice(struct SwsContext *c, const uint8_t *const src[],
+                        const int srcStride[], uint8_t *const dst[],
+                        const int dstStride[], int dstSliceY, int dstSliceH);
+
 /**
  * @param dstRange flag indicating the while-black range of the output (1=jpeg / 0=mpeg)
  * @param srcRange flag indicating the while-black range of the input (1=jpeg / 0=mpeg)
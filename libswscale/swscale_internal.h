@@ -394,6 +394,8 @@ typedef struct SwsContext {
 
     int canMMXEXTBeUsed;
     int warned_unuseable_bilinear;
+    int warned_unaligned_stride;
+    int warned_unaligned_data;
 
     int dstY;                     ///< Last destination vertical line output from last slice.
     int flags;                    ///< Flags passed by the user to select scaler algorithm, optimizations, subsampling, etc...
@@ -0,0 +1,199 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check that an image assembled from bands scaled with
+ * sws_scale_dst_slice() is identical to the output of sws_scale().
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#undef HAVE_AV_CONFIG_H
+#include "libavutil/common.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+
+#define MAX_BANDS 5
+
+static const enum AVPixelFormat src_fmts[] = {
+    AV_PIX_FMT_YUV420P,
+    AV_PIX_FMT_RGB24,
+};
+
+static const enum AVPixelFormat dst_fmts[] = {
+    AV_PIX_FMT_YUV420P,
+    AV_PIX_FMT_YUV422P,
+    AV_PIX_FMT_YUV420P10LE,
+    AV_PIX_FMT_NV12,
+    AV_PIX_FMT_RGB24,
+    AV_PIX_FMT_BGRA,
+    AV_PIX_FMT_RGB8,
+    AV_PIX_FMT_GRAY8,
+};
+
+static const int flags[] = {
+    SWS_FAST_BILINEAR,
+    SWS_BILINEAR,
+    SWS_BICUBIC,
+    SWS_POINT,
+    SWS_LANCZOS,
+};
+
+static const int dst_sizes[][2] = {
+    { 131,  97 },
+    {  64,  50 },
+    {  96, 160 },
+};
+
+#define SRC_W 96
+#define SRC_H 80
+
+static int compare(uint8_t *const a[4], const int a_stride[4],
+                   uint8_t *const b[4], const int b_stride[4],
+                   enum AVPixelFormat fmt, int w, int h)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
+    int nb_planes = av_pix_fmt_count_planes(fmt);
+    int p, y;
+
+    /* the palette of pseudo-paletted formats is not written by the scaler */
+    if (desc->flags & AV_PIX_FMT_FLAG_PSEUDOPAL)
+        nb_planes = 1;
+
+    for (p = 0; p < nb_planes; p++) {
+        int bytes = av_image_get_linesize(fmt, w, p);
+        int ph    = (p == 1 || p == 2) ? AV_CEIL_RSHIFT(h, desc->log2_chroma_h) : h;
+
+        for (y = 0; y < ph; y++)
+            if (memcmp(a[p] + y * a_stride[p], b[p] + y * b_stride[p], bytes))
+                return y << 2 | p;
+    }
+    return -1;
+}
+
+static int run_test(const uint8_t *const src[4], const int src_stride[4],
+                    enum AVPixelFormat src_fmt, enum AVPixelFormat dst_fmt,
+                    int dst_w, int dst_h, int flag, int nb_bands)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(dst_fmt);
+    struct SwsContext *ref_ctx, *band_ctx[MAX_BANDS] = { NULL };
+    uint8_t *ref[4] = { NULL }, *out[4] = { NULL };
+    int ref_stride[4], out_stride[4];
+    int nb_rows = AV_CEIL_RSHIFT(dst_h, desc->log2_chroma_h);
+    int i, ret = 0, diff;
+
+    ref_ctx = sws_getContext(SRC_W, SRC_H, src_fmt, dst_w, dst_h, dst_fmt,
+                             flag, NULL, NULL, NULL);
+    if (!ref_ctx)
+        return AVERROR(ENOMEM);
+    if (!sws_isSupportedDstSlice(ref_ctx))
+        goto end;
+
+    if ((ret = av_image_alloc(ref, ref_stride, dst_w, dst_h, dst_fmt, 16)) < 0 ||
+        (ret = av_image_alloc(out, out_stride, dst_w, dst_h, dst_fmt, 16)) < 0)
+        goto end;
+    memset(out[0], 0, ret);
+
+    ret = sws_scale(ref_ctx, src, src_stride, 0, SRC_H, ref, ref_stride);
+    if (ret < 0)
+        goto end;
+
+    /* one context per band, as a slice threaded caller would do, and the
+     * bands in reverse order to check that no state is carried over */
+    for (i = nb_bands - 1; i >= 0; i--) {
+        int start = ((nb_rows *  i     ) / nb_bands) << desc->log2_chroma_h;
+        int end   = FFMIN(((nb_rows * (i + 1)) / nb_bands) << desc->log2_chroma_h, dst_h);
+
+        band_ctx[i] = sws_getContext(SRC_W, SRC_H, src_fmt, dst_w, dst_h, dst_fmt,
+                                     flag, NULL, NULL, NULL);
+        if (!band_ctx[i]) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        ret = sws_scale_dst_slice(band_ctx[i], src, src_stride, out, out_stride,
+                                  start, end - start);
+        if (ret != end - start) {
+            fprintf(stderr, "%s -> %s %dx%d flags 0x%x: band %d returned %d\n",
+                    av_get_pix_fmt_name(src_fmt), av_get_pix_fmt_name(dst_fmt),
+                    dst_w, dst_h, flag, i, ret);
+            ret = AVERROR(EINVAL);
+            goto end;
+        }
+    }
+
+    ret  = 0;
+    diff = compare(ref, ref_stride, out, out_stride, dst_fmt, dst_w, dst_h);
+    if (diff >= 0) {
+        printf("%s -> %s %dx%d flags 0x%x, %d bands: mismatch in plane %d line %d\n",
+               av_get_pix_fmt_name(src_fmt), av_get_pix_fmt_name(dst_fmt),
+               dst_w, dst_h, flag, nb_bands, diff & 3, diff >> 2);
+        ret = 1;
+    }
+
+end:
+    for (i = 0; i < MAX_BANDS; i++)
+        sws_freeContext(band_ctx[i]);
+    sws_freeContext(ref_ctx);
+    av_freep(&ref[0]);
+    av_freep(&out[0]);
+    return ret;
+}
+
+int main(void)
+{
+    uint8_t *src[4];
+    int src_stride[4];
+    AVLFG rand;
+    int s, d, f, z, b, i, ret, failed = 0;
+
+    av_lfg_init(&rand, 1);
+
+    for (s = 0; s < FF_ARRAY_ELEMS(src_fmts); s++) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(src_fmts[s]);
+
+        if (av_image_alloc(src, src_stride, SRC_W, SRC_H, src_fmts[s], 16) < 0)
+            return 1;
+        for (i = 0; i < av_pix_fmt_count_planes(src_fmts[s]); i++) {
+            int j, h = (i == 1 || i == 2) ? AV_CEIL_RSHIFT(SRC_H, desc->log2_chroma_h) : SRC_H;
+            for (j = 0; j < src_stride[i] * h; j++)
+                src[i][j] = av_lfg_get(&rand);
+        }
+
+        for (d = 0; d < FF_ARRAY_ELEMS(dst_fmts); d++)
+        for (f = 0; f < FF_ARRAY_ELEMS(flags); f++)
+        for (z = 0; z < FF_ARRAY_ELEMS(dst_sizes); z++)
+        for (b = 2; b <= MAX_BANDS; b += 3) {
+            ret = run_test((const uint8_t * const *)src, src_stride,
+                           src_fmts[s], dst_fmts[d],
+                           dst_sizes[z][0], dst_sizes[z][1], flags[f], b);
+            if (ret < 0) {
+                av_freep(&src[0]);
+                return 1;
+            }
+            failed |= ret;
+        }
+        av_freep(&src[0]);
+    }
+
+    return failed;
+}
@@ -89,6 +89,9 @@ static const struct {
     #if CONFIG_H264QPEL
         { "h264qpel", checkasm_check_h264qpel },
     #endif
+    #if CONFIG_HEVC_DECODER
+        { "hevc_pred", checkasm_check_hevc_pred },
+    #endif
     #if CONFIG_JPEG2000_DECODER
         { "jpeg2000dsp", checkasm_check_jpeg2000dsp },
     #endif
@@ -112,6 +115,12 @@ static const struct {
     #if CONFIG_COLORSPACE_FILTER
         { "vf_colorspace", checkasm_check_colorspace },
     #endif
+    #if CONFIG_NNEDI_FILTER
+        { "vf_nnedi", checkasm_check_nnedi },
+    #endif
+    #if CONFIG_OVERLAY_FILTER
+        { "vf_overlay", checkasm_check_overlay },
+    #endif
 #endif
     { NULL }
 };
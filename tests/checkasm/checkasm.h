@@ -39,7 +39,10 @@ void checkasm_check_fmtconvert(void);
 void checkasm_check_h264dsp(void);
 void checkasm_check_h264pred(void);
 void checkasm_check_h264qpel(void);
+void checkasm_check_hevc_pred(void);
 void checkasm_check_jpeg2000dsp(void);
+void checkasm_check_nnedi(void);
+void checkasm_check_overlay(void);
 void checkasm_check_pixblockdsp(void);
 void checkasm_check_synth_filter(void);
 void checkasm_check_v210enc(void);
@@ -0,0 +1,165 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavcodec/hevcpred.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/intreadwrite.h"
+
+static const uint32_t pixel_mask[5] = { 0xffffffff, 0x01ff01ff, 0x03ff03ff, 0x07ff07ff, 0x0fff0fff };
+
+#define SIZEOF_PIXEL ((bit_depth + 7) / 8)
+#define STRIDE       64             /* in pixels, like the decoder passes it */
+#define BUF_SIZE     (64 * 33 * 2)   /* 32 rows of 64 pixels and one row of guard */
+#define EDGE_SIZE    ((4 * 32 + 8) * 2)
+
+/* The decoder passes top and left edges of 2 * size + 1 pixels each, with
+ * the shared top-left sample at index -1 of both. */
+#define randomize_edges()                                   \
+    do {                                                    \
+        uint32_t mask = pixel_mask[bit_depth - 8];          \
+        int i;                                              \
+        for (i = 0; i < EDGE_SIZE; i += 4)                  \
+            AV_WN32A(edge + i, rnd() & mask);               \
+        if (bit_depth == 8)                                 \
+            left[-1] = top[-1];                             \
+        else                                                \
+            AV_WN16(left - 2, AV_RN16(top - 2));            \
+    } while (0)
+
+#define clear_buffers()                                     \
+    do {                                                    \
+        memset(buf0, 0x5a, BUF_SIZE);                       \
+        memset(buf1, 0x5a, BUF_SIZE);                       \
+    } while (0)
+
+static void check_pred_planar(HEVCPredContext *h, uint8_t *buf0, uint8_t *buf1,
+                              uint8_t *edge, int bit_depth)
+{
+    uint8_t *top  = edge + 2 * SIZEOF_PIXEL;
+    uint8_t *left = top  + 2 * 32 * SIZEOF_PIXEL + 2 * SIZEOF_PIXEL;
+    int log2_size;
+
+    declare_func(void, uint8_t *src, const uint8_t *top,
+                 const uint8_t *left, ptrdiff_t stride);
+
+    for (log2_size = 2; log2_size <= 5; log2_size++) {
+        int size = 1 << log2_size;
+
+        if (check_func(h->pred_planar[log2_size - 2], "hevc_pred_planar_%dx%d_%d",
+                       size, size, bit_depth)) {
+            randomize_edges();
+            clear_buffers();
+            call_ref(buf0, top, left, STRIDE);
+            call_new(buf1, top, left, STRIDE);
+            if (memcmp(buf0, buf1, BUF_SIZE))
+                fail();
+            bench_new(buf1, top, left, STRIDE);
+        }
+    }
+}
+
+static void check_pred_dc(HEVCPredContext *h, uint8_t *buf0, uint8_t *buf1,
+                          uint8_t *edge, int bit_depth)
+{
+    uint8_t *top  = edge + 2 * SIZEOF_PIXEL;
+    uint8_t *left = top  + 2 * 32 * SIZEOF_PIXEL + 2 * SIZEOF_PIXEL;
+    int log2_size, c_idx;
+
+    declare_func(void, uint8_t *src, const uint8_t *top, const uint8_t *left,
+                 ptrdiff_t stride, int log2_size, int c_idx);
+
+    for (log2_size = 2; log2_size <= 5; log2_size++) {
+        int size = 1 << log2_size;
+
+        for (c_idx = 0; c_idx <= 1; c_idx++) {
+            if (check_func(h->pred_dc, "hevc_pred_dc_%dx%d_%s_%d", size, size,
+                           c_idx ? "chroma" : "luma", bit_depth)) {
+                randomize_edges();
+                clear_buffers();
+                call_ref(buf0, top, left, STRIDE, log2_size, c_idx);
+                call_new(buf1, top, left, STRIDE, log2_size, c_idx);
+                if (memcmp(buf0, buf1, BUF_SIZE))
+                    fail();
+                bench_new(buf1, top, left, STRIDE, log2_size, c_idx);
+            }
+        }
+    }
+}
+
+static void check_pred_angular(HEVCPredContext *h, uint8_t *buf0, uint8_t *buf1,
+                               uint8_t *edge, int bit_depth)
+{
+    uint8_t *top  = edge + 2 * SIZEOF_PIXEL;
+    uint8_t *left = top  + 2 * 32 * SIZEOF_PIXEL + 2 * SIZEOF_PIXEL;
+    int log2_size, c_idx, mode;
+
+    declare_func(void, uint8_t *src, const uint8_t *top, const uint8_t *left,
+                 ptrdiff_t stride, int c_idx, int mode);
+
+    for (log2_size = 2; log2_size <= 5; log2_size++) {
+        int size = 1 << log2_size;
+
+        for (mode = 2; mode <= 34; mode++) {
+            /* only the pure horizontal and vertical modes filter luma edges */
+            for (c_idx = 0; c_idx <= (mode == 10 || mode == 26); c_idx++) {
+                if (check_func(h->pred_angular[log2_size - 2],
+                               "hevc_pred_angular_%dx%d_mode%d%s_%d", size, size,
+                               mode, (mode == 10 || mode == 26) ? (c_idx ? "_chroma" : "_luma") : "",
+                               bit_depth)) {
+                    randomize_edges();
+                    clear_buffers();
+                    call_ref(buf0, top, left, STRIDE, c_idx, mode);
+                    call_new(buf1, top, left, STRIDE, c_idx, mode);
+                    if (memcmp(buf0, buf1, BUF_SIZE))
+                        fail();
+                    bench_new(buf1, top, left, STRIDE, c_idx, mode);
+                }
+            }
+        }
+    }
+}
+
+void checkasm_check_hevc_pred(void)
+{
+    static const struct {
+        void (*func)(HEVCPredContext*, uint8_t*, uint8_t*, uint8_t*, int);
+        const char *name;
+    } tests[] = {
+        { check_pred_planar,  "planar"  },
+        { check_pred_dc,      "dc"      },
+        { check_pred_angular, "angular" },
+    };
+    static const int bit_depths[] = { 8, 9, 10, 12 };
+
+    LOCAL_ALIGNED_32(uint8_t, buf0, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, buf1, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, edge, [EDGE_SIZE]);
+    HEVCPredContext h;
+    int test, i;
+
+    for (test = 0; test < FF_ARRAY_ELEMS(tests); test++) {
+        for (i = 0; i < FF_ARRAY_ELEMS(bit_depths); i++) {
+            ff_hevc_pred_init(&h, bit_depths[i]);
+            tests[test].func(&h, buf0, buf1, edge, bit_depths[i]);
+        }
+        report("%s", tests[test].name);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/nnedi.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+
+#define MAX_N   64
+#define MAX_LEN 288
+#define EXP_N   256
+
+#define randomize_float(buf, len, lo, hi)                                      \
+    do {                                                                       \
+        int i;                                                                 \
+        for (i = 0; i < len; i++)                                              \
+            buf[i] = lo + (hi - lo) * (rnd() / (float)UINT_MAX);              \
+    } while (0)
+
+void checkasm_check_nnedi(void)
+{
+    /* the shapes of the prescreener and predictor networks */
+    static const int sizes[][2] = {
+        {  4,   4 }, {  4,   8 }, {  4,  48 },
+        { 32,  32 }, { 32,  48 }, { 64,  96 }, { 64, 288 },
+    };
+    LOCAL_ALIGNED_32(float, data,    [MAX_LEN]);
+    LOCAL_ALIGNED_32(float, weights, [MAX_N * (MAX_LEN + 1)]);
+    LOCAL_ALIGNED_32(float, vals0,   [MAX_N]);
+    LOCAL_ALIGNED_32(float, vals1,   [MAX_N]);
+    LOCAL_ALIGNED_32(float, src,     [EXP_N]);
+    LOCAL_ALIGNED_32(float, dst0,    [EXP_N]);
+    LOCAL_ALIGNED_32(float, dst1,    [EXP_N]);
+    NNEDIDSPContext dsp;
+    int i;
+
+    ff_nnedi_init(&dsp);
+
+    if (check_func(dsp.dot_prod, "nnedi_dot_prod")) {
+        declare_func(void, const float *data, const float *weights,
+                     float *vals, int n, int len, float scale);
+
+        for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+            int n = sizes[i][0], len = sizes[i][1];
+
+            /* pixel values against weights normalized for them */
+            randomize_float(data, len, 0.0f, 255.0f);
+            randomize_float(weights, n * (len + 1), -1.0f / 256, 1.0f / 256);
+            call_ref(data, weights, vals0, n, len, 0.5f);
+            call_new(data, weights, vals1, n, len, 0.5f);
+            if (!float_near_abs_eps_array(vals0, vals1, 1.0e-3f, n))
+                fail();
+        }
+        bench_new(data, weights, vals1, MAX_N, MAX_LEN, 0.5f);
+    }
+
+    if (check_func(dsp.expfunc, "nnedi_exp")) {
+        declare_func(void, float *s, int n);
+
+        for (i = 16; i <= EXP_N; i += 16) {
+            /* cover the clipping on both sides */
+            randomize_float(src, i, -90.0f, 90.0f);
+            memcpy(dst0, src, i * sizeof(*src));
+            memcpy(dst1, src, i * sizeof(*src));
+            call_ref(dst0, i);
+            call_new(dst1, i);
+            if (!float_near_ulp_array(dst0, dst1, 2, i))
+                fail();
+        }
+        bench_new(dst1, EXP_N);
+    }
+
+    report("nnedi");
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/overlay.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+
+#define WIDTH 256
+#define BUF_SIZE (WIDTH + 32)
+#define ALPHA_STRIDE (2 * BUF_SIZE)
+
+/* Mostly random alpha, with runs of fully transparent and opaque pixels
+ * like a typical logo has. */
+static void randomize_buffers(uint8_t *dst0, uint8_t *dst1, uint8_t *src,
+                              uint8_t *alpha)
+{
+    int i;
+
+    for (i = 0; i < BUF_SIZE; i++) {
+        dst0[i] = dst1[i] = rnd();
+        src[i]  = rnd();
+    }
+    for (i = 0; i < 2 * ALPHA_STRIDE; i++) {
+        int r = rnd() & 0xff;
+        alpha[i] = r < 32 ? 0 : r > 224 ? 255 : r;
+    }
+}
+
+void checkasm_check_overlay(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, dst0,  [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1,  [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, src,   [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, alpha, [2 * ALPHA_STRIDE]);
+    OverlayDSPContext dsp;
+    int w;
+
+    ff_overlay_init(&dsp);
+
+    if (check_func(dsp.blend_row, "overlay_blend_row")) {
+        declare_func(void, uint8_t *dst, const uint8_t *src,
+                     const uint8_t *alpha, int w);
+
+        for (w = 16; w <= WIDTH; w += 16) {
+            /* every other width starts unaligned */
+            int off = (w >> 4) & 1;
+            randomize_buffers(dst0, dst1, src, alpha);
+            call_ref(dst0 + off, src + off, alpha + off, w);
+            call_new(dst1 + off, src + off, alpha + off, w);
+            if (memcmp(dst0, dst1, BUF_SIZE))
+                fail();
+        }
+        bench_new(dst1, src, alpha, WIDTH);
+    }
+
+    if (check_func(dsp.blend_row_420, "overlay_blend_row_420")) {
+        declare_func(void, uint8_t *dst, const uint8_t *src,
+                     const uint8_t *alpha, ptrdiff_t alpha_linesize, int w);
+
+        for (w = 16; w <= WIDTH; w += 16) {
+            int off = (w >> 4) & 1;
+            randomize_buffers(dst0, dst1, src, alpha);
+            call_ref(dst0 + off, src + off, alpha + 2 * off, ALPHA_STRIDE, w);
+            call_new(dst1 + off, src + off, alpha + 2 * off, ALPHA_STRIDE, w);
+            if (memcmp(dst0, dst1, BUF_SIZE))
+                fail();
+        }
+        bench_new(dst1, src, alpha, ALPHA_STRIDE, WIDTH);
+    }
+
+    report("overlay");
+}
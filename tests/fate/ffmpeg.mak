@@ -56,3 +56,14 @@ fate-limited_input_seek: $(TARGET_SAMPLES)/vorbis/moog_small.ogg
 fate-limited_input_seek: CMD = md5 -ss 1.5 -t 1.3 -i $(TARGET_SAMPLES)/vorbis/moog_small.ogg -c:a copy -fflags +bitexact -f ogg
 fate-limited_input_seek-copyts: $(TARGET_SAMPLES)/vorbis/moog_small.ogg
 fate-limited_input_seek-copyts: CMD = md5 -ss 1.5 -t 1.3 -i $(TARGET_SAMPLES)/vorbis/moog_small.ogg -c:a copy -copyts -fflags +bitexact -f ogg
+
+FATE_FFMPEG_ENC_THREAD = fate-ffmpeg-enc-serial fate-ffmpeg-enc-threaded
+FATE_FFMPEG-$(call ALLYES, RAWVIDEO_DEMUXER MPEG4_ENCODER MPEG2VIDEO_ENCODER AVI_MUXER) += $(FATE_FFMPEG_ENC_THREAD)
+$(FATE_FFMPEG_ENC_THREAD): tests/data/vsynth1.yuv
+fate-ffmpeg-enc-serial:   ENC_THREAD_OPTS =
+fate-ffmpeg-enc-threaded: ENC_THREAD_OPTS = -enc_thread_queue_size 4
+fate-ffmpeg-enc-threaded: REF = $(SRC_PATH)/tests/ref/fate/ffmpeg-enc-serial
+$(FATE_FFMPEG_ENC_THREAD): CMD = ffmpeg $(ENC_THREAD_OPTS) \
+  -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv \
+  -c:v mpeg4 -qscale 10 -threads 1 -flags +bitexact -fflags +bitexact -f avi md5: \
+  -c:v mpeg2video -qscale 8 -threads 1 -flags +bitexact -fflags +bitexact -f avi md5:
@@ -2,6 +2,10 @@
 #fate-async: libavformat/tests/async$(EXESUF)
 #fate-async: CMD = run libavformat/tests/async
 
+FATE_LIBAVFORMAT-$(CONFIG_FRAMECRC_MUXER) += fate-interleave
+fate-interleave: libavformat/tests/interleave$(EXESUF)
+fate-interleave: CMD = run libavformat/tests/interleave
+
 FATE_LIBAVFORMAT-$(CONFIG_NETWORK) += fate-noproxy
 fate-noproxy: libavformat/tests/noproxy$(EXESUF)
 fate-noproxy: CMD = run libavformat/tests/noproxy
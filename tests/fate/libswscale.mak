@@ -0,0 +1,7 @@
+FATE_LIBSWSCALE += fate-sws-dst-slice
+fate-sws-dst-slice: libswscale/tests/dstslice$(EXESUF)
+fate-sws-dst-slice: CMD = run libswscale/tests/dstslice
+fate-sws-dst-slice: REF = /dev/null
+
+FATE-$(CONFIG_SWSCALE) += $(FATE_LIBSWSCALE)
+fate-libswscale: $(FATE_LIBSWSCALE)